@@ -19,9 +19,12 @@
 #include "bf_document.hpp"     /* IDocument        */
 #include "bf_model_loader.hpp" /* Mesh             */
 
+#include <algorithm> /* for_each_n, upper_bound */
+
 namespace bf
 {
-  static constexpr std::uint8_t k_InvalidBoneID = static_cast<std::uint8_t>(-1);
+  static constexpr std::uint8_t  k_InvalidBoneID  = static_cast<std::uint8_t>(-1);
+  static constexpr std::uint32_t k_InvalidNodeIdx = static_cast<std::uint32_t>(-1);
 
   class Engine;
   struct StandardVertex;
@@ -141,6 +144,26 @@ namespace bf
   class Anim3DAsset : public BaseAsset<Anim3DAsset>
   {
    public:
+    //
+    // The key a track was last sampled at, kept per playing instance
+    // so that the next sample can start searching from there.
+    //
+    using KeyCursor = std::uint32_t;
+
+    struct TripleCursor
+    {
+      KeyCursor x = 0u;
+      KeyCursor y = 0u;
+      KeyCursor z = 0u;
+    };
+
+    struct ChannelCursor
+    {
+      KeyCursor    rotation    = 0u;
+      TripleCursor translation = {};
+      TripleCursor scale       = {};
+    };
+
     template<typename T>
     struct Track
     {
@@ -166,16 +189,52 @@ namespace bf
 
         assert(num_keys > 1);
 
-        for (std::size_t i = 0; i < num_keys - 1; ++i)
+        // The first key after `time`, the key before it is the one `time` is in.
+        const Key* const next_key = std::upper_bound(
+         keys + 1,
+         keys + num_keys,
+         time,
+         [](AnimationTimeType lhs, const Key& rhs) { return lhs < rhs.time; });
+
+        if (next_key == keys + num_keys)
+        {
+          assert(!"Invalid time passed in.");
+          return -1;
+        }
+
+        return std::size_t(next_key - keys) - 1u;
+      }
+
+      //
+      // Normal playback only moves forward a key or so per frame, so this
+      // checks the few keys after `cursor` before doing a full search.
+      // Seeking backwards or looping around falls back to `findKey` above.
+      //
+      std::size_t findKey(AnimationTimeType time, IMemoryManager& mem, KeyCursor& cursor) const
+      {
+        static constexpr std::size_t k_MaxCursorSteps = 4u;
+
+        const std::size_t num_keys = numKeys(mem);
+
+        assert(num_keys > 1);
+
+        std::size_t key_index = cursor;
+
+        if (key_index < num_keys - 1u && keys[key_index].time <= time)
         {
-          if (time < keys[i + 1].time)
+          for (std::size_t step = 0u; step < k_MaxCursorSteps && key_index < num_keys - 1u; ++step, ++key_index)
           {
-            return i;
+            if (time < keys[key_index + 1u].time)
+            {
+              return cursor = KeyCursor(key_index);
+            }
           }
         }
 
-        assert(!"Invalid time passed in.");
-        return -1;
+        key_index = findKey(time, mem);
+        cursor    = KeyCursor(key_index);
+
+        return key_index;
       }
 
       void destroy(IMemoryManager& mem)
@@ -238,12 +297,51 @@ namespace bf
       }
     };
 
+    //
+    // The local transform of a single channel at some point in time.
+    //
+    struct ChannelPose
+    {
+      Vector3f      translation;
+      bfQuaternionf rotation;
+      Vector3f      scale;
+    };
+
+    //
+    // What a 16bit value of a channel's translation or scale is relative to,
+    // `value = min + quantized / 65535 * extent`.
+    //
+    struct QuantizedRange
+    {
+      float min[3];
+      float extent[3];
+    };
+
+    //
+    // Every channel resampled at a fixed rate so that sampling does
+    // not need to search for keys, stored one frame after another.
+    //
+    // Frame Layout: [Rotation x num_channels][Translation x num_channels][Scale x num_channels]
+    //   Rotation:    4 x int16  (normalized to [-1, 1])
+    //   Translation: 3 x uint16 (relative to the channel's `translation_ranges`)
+    //   Scale:       3 x uint16 (relative to the channel's `scale_ranges`)
+    //
+    struct BakedClip
+    {
+      AnimationTimeType frames_per_tick    = 0.0;
+      std::uint32_t     num_frames         = 0u;
+      QuantizedRange*   translation_ranges = nullptr;  //!< One per channel.
+      QuantizedRange*   scale_ranges       = nullptr;  //!< One per channel.
+      std::uint16_t*    frames             = nullptr;  //!< `num_frames` frames of `frameStride` values each.
+    };
+
    public:
     IMemoryManager&                 m_Memory;
     AnimationTimeType               m_Duration;
     AnimationTimeType               m_TicksPerSecond;
     std::uint8_t                    m_NumChannels;
-    Channel*                        m_Channels;
+    Channel*                        m_Channels;  //!< The source keys, freed once the animation has been baked.
+    BakedClip                       m_BakedClip;
     HashTable<String, std::uint8_t> m_NameToChannel;
 
    public:
@@ -253,6 +351,7 @@ namespace bf
       m_TicksPerSecond{AnimationTimeType(0)},
       m_NumChannels{0u},
       m_Channels{nullptr},
+      m_BakedClip{},
       m_NameToChannel{}
     {
     }
@@ -263,20 +362,54 @@ namespace bf
       m_Channels    = static_cast<Channel*>(m_Memory.allocate(num_bones * sizeof(Channel)));
     }
 
+    [[nodiscard]] bool        isBaked() const { return m_BakedClip.frames != nullptr; }
+    [[nodiscard]] std::size_t frameStride() const { return std::size_t(m_NumChannels) * 10u; }
+
+    //
+    // Resamples the keys of every channel `samples_per_second` times a second
+    // into `m_BakedClip` and then frees the keys.
+    // An animation with no duration is left as is.
+    //
+    void bake(AnimationTimeType samples_per_second);
+
+    //
+    // Writes out `m_NumChannels` poses, `time` is in ticks.
+    // Only valid once the animation has been baked.
+    //
+    void samplePose(AnimationTimeType time, ChannelPose* out_poses) const;
+
     void destroy()
     {
-      std::for_each_n(
-       m_Channels, m_NumChannels, [this](Channel& channel) {
-         channel.destroy(m_Memory);
-       });
+      destroyChannels();
 
-      m_Memory.deallocate(m_Channels, m_NumChannels * sizeof(Channel));
+      if (isBaked())
+      {
+        m_Memory.deallocateArray(m_BakedClip.translation_ranges);
+        m_Memory.deallocateArray(m_BakedClip.scale_ranges);
+        m_Memory.deallocateArray(m_BakedClip.frames);
+        m_BakedClip = {};
+      }
     }
 
     ClassID::Type classID() const override
     {
       return ClassID::ANIMATION3D_ASSET;
     }
+
+   private:
+    void destroyChannels()
+    {
+      if (m_Channels)
+      {
+        std::for_each_n(
+         m_Channels, m_NumChannels, [this](Channel& channel) {
+           channel.destroy(m_Memory);
+         });
+
+        m_Memory.deallocate(m_Channels, m_NumChannels * sizeof(Channel));
+        m_Channels = nullptr;
+      }
+    }
   };
 
   // TODO(SR): This should be declared in a better place.
@@ -292,6 +425,7 @@ namespace bf
       String        name;
       Matrix4x4f    transform;
       std::uint8_t  bone_idx;
+      std::uint32_t parent_idx;  //!< Always less than the index of this node, `k_InvalidNodeIdx` for the root.
       std::uint32_t first_child;
       std::uint32_t num_children;
     };
@@ -308,7 +442,7 @@ namespace bf
     bfBufferHandle        m_IndexBuffer;
     bfBufferHandle        m_VertexBoneData;
     Array<Mesh>           m_Meshes;
-    Array<Node>           m_Nodes;
+    Array<Node>           m_Nodes;  //!< Parents always come before their children.
     Array<NodeIDBone>     m_BoneToModel;
     Array<MaterialAsset*> m_Materials;
     Matrix4x4f            m_GlobalInvTransform;
@@ -23,11 +23,17 @@
 #include "bf/graphics/bifrost_standard_renderer.hpp"
 #include "bf/utility/bifrost_json.hpp"
 
+#include <algorithm>  // clamp, max, min
+#include <cmath>      // ceil, lround
+
 namespace bf
 {
   // TODO(SR): This is copied from "bifrost_standard_renderer.cpp"
   static const bfTextureSamplerProperties k_SamplerNearestRepeat = bfTextureSamplerProperties_init(BF_SFM_NEAREST, BF_SAM_CLAMP_TO_EDGE);
 
+  // Rate animations are resampled at on import, see `Anim3DAsset::bake`.
+  static constexpr AnimationTimeType k_AnimationBakeSamplesPerSecond = 30.0;
+
   // TODO(SR): We dont want these. \/
   LinearAllocator&  ENGINE_TEMP_MEM(Engine& engine);
   bfGfxDeviceHandle ENGINE_GFX_DEVICE(Engine& engine);
@@ -161,6 +167,236 @@ namespace bf
     });
   }
 
+  static constexpr float k_QuantizedUNormMax = 65535.0f;
+  static constexpr float k_QuantizedSNormMax = 32767.0f;
+
+  static std::uint16_t quantizeUNorm(float value, float min, float extent)
+  {
+    return extent > 0.0f ? std::uint16_t(std::lround(std::clamp((value - min) / extent, 0.0f, 1.0f) * k_QuantizedUNormMax)) : std::uint16_t(0u);
+  }
+
+  static float dequantizeUNorm(std::uint16_t value, float min, float extent)
+  {
+    return min + float(value) * (extent / k_QuantizedUNormMax);
+  }
+
+  static std::uint16_t quantizeSNorm(float value)
+  {
+    return std::uint16_t(std::int16_t(std::lround(std::clamp(value, -1.0f, 1.0f) * k_QuantizedSNormMax)));
+  }
+
+  static float dequantizeSNorm(std::uint16_t value)
+  {
+    return float(std::int16_t(value)) / k_QuantizedSNormMax;
+  }
+
+  // Unlike the runtime sampling this clamps to the first and last key since
+  // the baked frames land right on the start and end of the animation.
+  template<typename T, typename F>
+  static T sampleTrack(const Anim3DAsset::Track<T>& track,
+                       IMemoryManager&              memory,
+                       Anim3DAsset::KeyCursor&      cursor,
+                       AnimationTimeType            time,
+                       T                            default_value,
+                       F&&                          lerp_fn)
+  {
+    const std::size_t num_keys = track.numKeys(memory);
+
+    if (num_keys == 0u)
+    {
+      return default_value;
+    }
+
+    if (num_keys == 1u || time <= track.keys[0].time)
+    {
+      return track.keys[0].value;
+    }
+
+    if (time >= track.keys[num_keys - 1u].time)
+    {
+      return track.keys[num_keys - 1u].value;
+    }
+
+    const std::size_t                          key_index = track.findKey(time, memory, cursor);
+    const typename Anim3DAsset::Track<T>::Key& curr_key  = track.keys[key_index];
+    const typename Anim3DAsset::Track<T>::Key& next_key  = track.keys[key_index + 1u];
+
+    return lerp_fn(curr_key.value, float((time - curr_key.time) / (next_key.time - curr_key.time)), next_key.value);
+  }
+
+  static Anim3DAsset::ChannelPose sampleChannel(const Anim3DAsset::Channel& channel, IMemoryManager& memory, Anim3DAsset::ChannelCursor& cursor, AnimationTimeType time)
+  {
+    const auto lerp_float = &math::lerp<float, float>;
+    const auto slerp_quat = [](const bfQuaternionf& start, float factor, const bfQuaternionf& end) {
+      return bfQuaternionf_slerp(&start, &end, factor);
+    };
+
+    Anim3DAsset::ChannelPose pose;
+
+    pose.translation = {
+     sampleTrack(channel.translation.x, memory, cursor.translation.x, time, 0.0f, lerp_float),
+     sampleTrack(channel.translation.y, memory, cursor.translation.y, time, 0.0f, lerp_float),
+     sampleTrack(channel.translation.z, memory, cursor.translation.z, time, 0.0f, lerp_float),
+     1.0f,
+    };
+    pose.rotation = sampleTrack(channel.rotation, memory, cursor.rotation, time, bfQuaternionf_identity(), slerp_quat);
+    pose.scale    = {
+     sampleTrack(channel.scale.x, memory, cursor.scale.x, time, 1.0f, lerp_float),
+     sampleTrack(channel.scale.y, memory, cursor.scale.y, time, 1.0f, lerp_float),
+     sampleTrack(channel.scale.z, memory, cursor.scale.z, time, 1.0f, lerp_float),
+     0.0f,
+    };
+
+    bfQuaternionf_normalize(&pose.rotation);
+
+    return pose;
+  }
+
+  void Anim3DAsset::bake(AnimationTimeType samples_per_second)
+  {
+    if (isBaked() || !m_Channels || m_Duration <= 0.0 || m_TicksPerSecond <= 0.0)
+    {
+      return;
+    }
+
+    // NOTE(SR):
+    //   The number of frames is rounded up so that the last frame lands right on `m_Duration`.
+    //   Each channel is sampled twice, once to find the range of its values and again to quantize them,
+    //   so that there is no need for a temporary full precision copy of the whole clip.
+
+    const std::uint32_t num_intervals = std::max(std::uint32_t(std::ceil(m_Duration / m_TicksPerSecond * samples_per_second)), 1u);
+    const std::size_t   stride        = frameStride();
+
+    m_BakedClip.frames_per_tick    = AnimationTimeType(num_intervals) / m_Duration;
+    m_BakedClip.num_frames         = num_intervals + 1u;
+    m_BakedClip.translation_ranges = m_Memory.allocateArrayTrivial<QuantizedRange>(m_NumChannels);
+    m_BakedClip.scale_ranges       = m_Memory.allocateArrayTrivial<QuantizedRange>(m_NumChannels);
+    m_BakedClip.frames             = m_Memory.allocateArrayTrivial<std::uint16_t>(m_BakedClip.num_frames * stride);
+
+    const auto frame_time = [this, num_intervals](std::uint32_t frame) {
+      return std::min(m_Duration * AnimationTimeType(frame) / AnimationTimeType(num_intervals), m_Duration);
+    };
+
+    for (std::size_t channel_index = 0u; channel_index < m_NumChannels; ++channel_index)
+    {
+      const Channel&  channel           = m_Channels[channel_index];
+      QuantizedRange& translation_range = m_BakedClip.translation_ranges[channel_index];
+      QuantizedRange& scale_range       = m_BakedClip.scale_ranges[channel_index];
+      float           translation_max[3];
+      float           scale_max[3];
+      ChannelCursor   cursor = {};
+
+      for (std::uint32_t frame = 0u; frame < m_BakedClip.num_frames; ++frame)
+      {
+        const ChannelPose pose           = sampleChannel(channel, m_Memory, cursor, frame_time(frame));
+        const float       translation[3] = {pose.translation.x, pose.translation.y, pose.translation.z};
+        const float       scale[3]       = {pose.scale.x, pose.scale.y, pose.scale.z};
+
+        for (int i = 0; i < 3; ++i)
+        {
+          translation_range.min[i] = frame ? std::min(translation_range.min[i], translation[i]) : translation[i];
+          translation_max[i]       = frame ? std::max(translation_max[i], translation[i]) : translation[i];
+          scale_range.min[i]       = frame ? std::min(scale_range.min[i], scale[i]) : scale[i];
+          scale_max[i]             = frame ? std::max(scale_max[i], scale[i]) : scale[i];
+        }
+      }
+
+      for (int i = 0; i < 3; ++i)
+      {
+        translation_range.extent[i] = translation_max[i] - translation_range.min[i];
+        scale_range.extent[i]       = scale_max[i] - scale_range.min[i];
+      }
+
+      cursor = {};
+
+      for (std::uint32_t frame = 0u; frame < m_BakedClip.num_frames; ++frame)
+      {
+        const ChannelPose    pose        = sampleChannel(channel, m_Memory, cursor, frame_time(frame));
+        std::uint16_t* const frame_data  = m_BakedClip.frames + frame * stride;
+        std::uint16_t* const rotation    = frame_data + channel_index * 4u;
+        std::uint16_t* const translation = frame_data + m_NumChannels * 4u + channel_index * 3u;
+        std::uint16_t* const scale       = frame_data + m_NumChannels * 7u + channel_index * 3u;
+
+        rotation[0] = quantizeSNorm(pose.rotation.x);
+        rotation[1] = quantizeSNorm(pose.rotation.y);
+        rotation[2] = quantizeSNorm(pose.rotation.z);
+        rotation[3] = quantizeSNorm(pose.rotation.w);
+
+        translation[0] = quantizeUNorm(pose.translation.x, translation_range.min[0], translation_range.extent[0]);
+        translation[1] = quantizeUNorm(pose.translation.y, translation_range.min[1], translation_range.extent[1]);
+        translation[2] = quantizeUNorm(pose.translation.z, translation_range.min[2], translation_range.extent[2]);
+
+        scale[0] = quantizeUNorm(pose.scale.x, scale_range.min[0], scale_range.extent[0]);
+        scale[1] = quantizeUNorm(pose.scale.y, scale_range.min[1], scale_range.extent[1]);
+        scale[2] = quantizeUNorm(pose.scale.z, scale_range.min[2], scale_range.extent[2]);
+      }
+    }
+
+    destroyChannels();
+  }
+
+  void Anim3DAsset::samplePose(AnimationTimeType time, ChannelPose* out_poses) const
+  {
+    assert(isBaked() && "Only a baked animation can be sampled this way.");
+
+    const std::uint32_t     last_frame  = m_BakedClip.num_frames - 1u;
+    const AnimationTimeType frame_pos   = std::clamp(time * m_BakedClip.frames_per_tick, AnimationTimeType(0.0), AnimationTimeType(last_frame));
+    const std::uint32_t     frame0      = std::min(std::uint32_t(frame_pos), last_frame);
+    const std::uint32_t     frame1      = std::min(frame0 + 1u, last_frame);
+    const float             factor      = float(frame_pos - AnimationTimeType(frame0));
+    const std::size_t       stride      = frameStride();
+    const std::uint16_t*    frame0_data = m_BakedClip.frames + frame0 * stride;
+    const std::uint16_t*    frame1_data = m_BakedClip.frames + frame1 * stride;
+
+    // Rotations are nlerp-ed, the frames are close enough together that it is not worth a slerp.
+
+    for (std::size_t i = 0u; i < m_NumChannels; ++i)
+    {
+      const std::uint16_t* const rotation0 = frame0_data + i * 4u;
+      const std::uint16_t* const rotation1 = frame1_data + i * 4u;
+      const float                q0[4]     = {dequantizeSNorm(rotation0[0]), dequantizeSNorm(rotation0[1]), dequantizeSNorm(rotation0[2]), dequantizeSNorm(rotation0[3])};
+      float                      q1[4]     = {dequantizeSNorm(rotation1[0]), dequantizeSNorm(rotation1[1]), dequantizeSNorm(rotation1[2]), dequantizeSNorm(rotation1[3])};
+
+      // Takes the shortest path between the two rotations.
+      if (q0[0] * q1[0] + q0[1] * q1[1] + q0[2] * q1[2] + q0[3] * q1[3] < 0.0f)
+      {
+        for (float& component : q1)
+        {
+          component = -component;
+        }
+      }
+
+      bfQuaternionf& rotation = out_poses[i].rotation;
+
+      rotation.x = math::lerp(q0[0], factor, q1[0]);
+      rotation.y = math::lerp(q0[1], factor, q1[1]);
+      rotation.z = math::lerp(q0[2], factor, q1[2]);
+      rotation.w = math::lerp(q0[3], factor, q1[3]);
+
+      bfQuaternionf_normalize(&rotation);
+    }
+
+    const auto sample_vec3 = [factor](const std::uint16_t* value0, const std::uint16_t* value1, const QuantizedRange& range, float w) {
+      return Vector3f{
+       math::lerp(dequantizeUNorm(value0[0], range.min[0], range.extent[0]), factor, dequantizeUNorm(value1[0], range.min[0], range.extent[0])),
+       math::lerp(dequantizeUNorm(value0[1], range.min[1], range.extent[1]), factor, dequantizeUNorm(value1[1], range.min[1], range.extent[1])),
+       math::lerp(dequantizeUNorm(value0[2], range.min[2], range.extent[2]), factor, dequantizeUNorm(value1[2], range.min[2], range.extent[2])),
+       w,
+      };
+    };
+
+    const std::uint16_t* const translations0 = frame0_data + m_NumChannels * 4u;
+    const std::uint16_t* const translations1 = frame1_data + m_NumChannels * 4u;
+    const std::uint16_t* const scales0       = frame0_data + m_NumChannels * 7u;
+    const std::uint16_t* const scales1       = frame1_data + m_NumChannels * 7u;
+
+    for (std::size_t i = 0u; i < m_NumChannels; ++i)
+    {
+      out_poses[i].translation = sample_vec3(translations0 + i * 3u, translations1 + i * 3u, m_BakedClip.translation_ranges[i], 1.0f);
+      out_poses[i].scale       = sample_vec3(scales0 + i * 3u, scales1 + i * 3u, m_BakedClip.scale_ranges[i], 0.0f);
+    }
+  }
+
   ModelAsset::ModelAsset(IMemoryManager& memory) :
     m_GraphicsDevice{nullptr},
     m_VertexBuffer{nullptr},
@@ -200,12 +436,29 @@ namespace bf
        dst_node.name         = src_node.name.data;
        dst_node.transform    = src_node.transform;
        dst_node.bone_idx     = src_node.model_to_bone_idx;
+       dst_node.parent_idx   = k_InvalidNodeIdx;
        dst_node.first_child  = src_node.first_child;
        dst_node.num_children = src_node.num_children;
 
        return dst_node;
      });
 
+    // NOTE(SR):
+    //   The loader writes out the nodes in level order so every parent is already
+    //   before its children, this lets a pose be evaluated with a single loop over `m_Nodes`.
+
+    for (std::uint32_t node_idx = 0u; node_idx < skeleton.num_nodes; ++node_idx)
+    {
+      const Node& node = dst_nodes[node_idx];
+
+      for (std::uint32_t child_idx = node.first_child; child_idx < node.first_child + node.num_children; ++child_idx)
+      {
+        assert(node_idx < child_idx && "Nodes must be sorted so that parents come before their children.");
+
+        dst_nodes[child_idx].parent_idx = node_idx;
+      }
+    }
+
     std::transform(
      &*skeleton.bones,
      &*skeleton.bones + skeleton.num_bones,
@@ -367,6 +620,8 @@ namespace bf
 
            animation->m_NameToChannel.insert(bfStringRange(channel.name), std::uint8_t(anim_channel_index));
          });
+
+        animation->bake(k_AnimationBakeSamplesPerSecond);
       });
 
       // Load Meshes
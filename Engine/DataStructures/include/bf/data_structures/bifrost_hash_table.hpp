@@ -18,7 +18,7 @@
 // TODO(Shareef): Be more Standards compliant and include headers for these.
 // uint8_t, size_t, aligned_storage, alignment_of, hash, equal_to
 
-#include <algorithm>        /* copy, min */
+#include <algorithm>        /* copy, min, max */
 #include <initializer_list> /* initializer_list */
 // #include <utility>          /* */
 
@@ -202,6 +202,9 @@ namespace bf
 
     [[nodiscard]] std::size_t capacity() const;
 
+    // Grows the table up front so that `num_elements` can be inserted without rehashing along the way.
+    void reserve(std::size_t num_elements);
+
     template<typename ConvertKey,
              typename ConvertValue,
              typename = typename std::enable_if<std::is_convertible<ConvertKey, TKey>::value, TKey>::type,
@@ -246,7 +249,7 @@ namespace bf
     void        destroy();
     HashT*      getNode(const TKey& key) const;
     HashT*      getFreeNode(const TKey& key);
-    void        rehash();
+    void        rehash(std::size_t new_capacity);
     HashT*      nodeAt(std::size_t index) const;
     std::size_t index(const TKey& key) const;
     std::size_t hash(const TKey& key) const;
@@ -414,6 +417,23 @@ namespace bf
     return node->value();
   }
 
+  template<typename TKey, typename TValue, std::size_t initial_size, typename Hasher, typename TEqual>
+  void HashTable<TKey, TValue, initial_size, Hasher, TEqual>::reserve(const std::size_t num_elements)
+  {
+    // NOTE(SR): Kept at most half full since an insert that runs out of probes forces a rehash anyway.
+    std::size_t new_capacity = std::max(m_Capacity, initial_size);
+
+    while (new_capacity < num_elements * 2)
+    {
+      new_capacity <<= 1;
+    }
+
+    if (new_capacity != m_Capacity)
+    {
+      rehash(new_capacity);
+    }
+  }
+
   template<typename TKey, typename TValue, std::size_t initial_size, typename Hasher, typename TEqual>
   typename HashTable<TKey, TValue, initial_size, Hasher, TEqual>::iterator HashTable<TKey, TValue, initial_size, Hasher, TEqual>::begin()
   {
@@ -478,7 +498,7 @@ namespace bf
       ++hashCode;
     }
 
-    rehash();
+    rehash(m_Capacity << 1);
     return insert(key, value);
   }
 
@@ -502,7 +522,7 @@ namespace bf
       ++hashCode;
     }
 
-    rehash();
+    rehash(m_Capacity << 1);
     return insert(key, std::forward<TValue&&>(value));
   }
 
@@ -556,7 +576,7 @@ namespace bf
 
     if (hashCode >= m_Capacity)
     {
-      rehash();
+      rehash(m_Capacity << 1);
       set(key, value);
     }
   }
@@ -691,16 +711,16 @@ namespace bf
       ++hashCode;
     }
 
-    this->rehash();
+    this->rehash(m_Capacity << 1);
     return this->getFreeNode(key);
   }
 
   template<typename TKey, typename TValue, std::size_t initial_size, typename Hasher, typename TEqual>
-  void HashTable<TKey, TValue, initial_size, Hasher, TEqual>::rehash()
+  void HashTable<TKey, TValue, initial_size, Hasher, TEqual>::rehash(const std::size_t new_capacity)
   {
     const auto old_capacity = this->m_Capacity;
 
-    m_Capacity <<= 1;
+    m_Capacity = new_capacity;
     HashT* const newTable = new HashT[m_Capacity]();
     HashT* const oldTable = m_Table;
     HashT*       walker   = oldTable;
@@ -6,6 +6,9 @@
 #include "bifrost_vec2.h"        /* Vec2i        */
 #include "bifrost_vec3.h"        /* Vec3f, Rectf */
 
+#include <stddef.h> /* size_t   */
+#include <stdint.h> /* uint32_t */
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -90,11 +93,35 @@ typedef struct bfFrustum
 
 } bfFrustum;
 
+//
+// A batch of AABBs stored with each component in it's own array,
+// each array must have at least `num_aabbs` elements.
+//
+typedef struct bfAABBSoA
+{
+  const float* min_x;
+  const float* min_y;
+  const float* min_z;
+  const float* max_x;
+  const float* max_y;
+  const float* max_z;
+  size_t       num_aabbs;
+
+} bfAABBSoA;
+
 BF_MATH_API void                bfFrustum_fromMatrix(bfFrustum* self, const Mat4x4* view_projection);
 BF_MATH_API bfFrustumTestResult bfFrustum_isPointInside(const bfFrustum* self, Vec3f point);
 BF_MATH_API bfFrustumTestResult bfFrustum_isSphereInside(const bfFrustum* self, Vec3f center, float radius);
 BF_MATH_API bfFrustumTestResult bfFrustum_isAABBInside(const bfFrustum* self, Vec3f aabb_min, Vec3f aabb_max);
 
+//
+// Sets bit `i % 32` of `out_visible_bits[i / 32]` if `aabbs[i]` is not completely outside of the frustum.
+// `out_visible_bits` must have room for `(aabbs->num_aabbs + 31) / 32` elements.
+//
+// Uses SSE to test four AABBs at a time when available.
+//
+BF_MATH_API void bfFrustum_cullAABBs(const bfFrustum* self, const bfAABBSoA* aabbs, uint32_t* out_visible_bits);
+
 /* Camera API */
 
 typedef enum CameraMode
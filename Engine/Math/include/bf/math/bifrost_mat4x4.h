@@ -64,11 +64,13 @@ BF_MATH_API void  Mat4x4_initLookAt(Mat4x4* self, const Vec3f* position, const V
 BF_MATH_API void  Mat4x4_copy(const Mat4x4* self, Mat4x4* outCopy);
 BF_MATH_API void  Mat4x4_transpose(Mat4x4* self);
 BF_MATH_API int   Mat4x4_inverse(const Mat4x4* self, Mat4x4* outInverse);
+BF_MATH_API int   Mat4x4_inverseAffine(const Mat4x4* self, Mat4x4* outInverse); /* Only valid when the bottom row is [0, 0, 0, 1], much cheaper than 'Mat4x4_inverse'. */
 BF_MATH_API float Mat4x4_det(const Mat4x4* self);
 BF_MATH_API float Mat4x4_trace(const Mat4x4* self);
 // The order is [self * other] which means other happens 'first'.
 // Ex: 'out = self * other'
 BF_MATH_API void Mat4x4_mult(const Mat4x4* self, const Mat4x4* other, Mat4x4* out);
+BF_MATH_API void Mat4x4_multAffine(const Mat4x4* self, const Mat4x4* other, Mat4x4* out); /* Both must have a bottom row of [0, 0, 0, 1], 'out' may alias either. */
 BF_MATH_API void Mat4x4_multVec(const Mat4x4* self, const Vec3f* vec, Vec3f* outVec);
 
 // New API
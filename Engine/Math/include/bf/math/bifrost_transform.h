@@ -13,6 +13,7 @@
 #include "bifrost_mat4x4.h"
 #include "bifrost_vec3.h"
 
+#include <stddef.h> /* size_t   */
 #include <stdint.h> /* uint32_t */
 
 #if __cplusplus
@@ -69,11 +70,6 @@ BF_MATH_API Vec3f         bfQuaternionf_forward(const Quaternionf* self);
 BF_MATH_API Vec3f         bfQuaternionf_backward(const Quaternionf* self);                         // negative z-axis
 BF_MATH_API bfQuaternionf bfQuaternionf_slerp(const bfQuaternionf* lhs, const bfQuaternionf* rhs, float factor);
 
-enum
-{
-  k_TransformQueueStackMax = 128,
-};
-
 typedef enum bfTransformFlags
 {
   BF_TRANSFORM_ORIGIN_DIRTY     = (1 << 0),
@@ -85,6 +81,10 @@ typedef enum bfTransformFlags
   BF_TRANSFORM_ADOPT_SCALE      = (1 << 5),
   BF_TRANSFORM_ADOPT_ROTATION   = (1 << 6),
   BF_TRANSFORM_ADOPT_POSITION   = (1 << 7),
+  BF_TRANSFORM_IN_DIRTY_LIST    = (1 << 8),  /*!< Linked into the `dirty_list`, cleared by whoever consumes the list.   */
+  BF_TRANSFORM_FLUSH_PENDING    = (1 << 9),  /*!< World values are stale until `bfTransform_flushDirtyList` is called. */
+  BF_TRANSFORM_DEFER_FLUSH      = (1 << 10), /*!< Setters only mark the transform dirty rather than flushing changes.   */
+  BF_TRANSFORM_PENDING_PARENT   = (1 << 11), /*!< Below a root from `bfTransform_takePendingRoots` until flushed.       */
 
   /* Helper Flags */
   BF_TRANSFORM_NONE        = 0x0,
@@ -108,6 +108,15 @@ typedef enum bfTransformFlags
         - 'bfTransform::local_scale'
     
     Or use the "Transform_set*" API for automatic flushing of changes.
+
+    Transforms with `BF_TRANSFORM_DEFER_FLUSH` set do not flush in the
+    setters, they are added to the dirty list instead and the world values
+    are updated by the next `bfTransform_flushDirtyList`. A parent moved
+    many times in a frame then only has its subtree recomputed once.
+
+    The inverse and normal matrices are not cached since most transforms
+    never need them, use 'bfTransform_inverseWorldMatrix' and
+    'bfTransform_normalMatrix' to calculate them from `world_transform`.
 */
 typedef struct bfTransform bfTransform;
 struct bfTransform
@@ -117,15 +126,12 @@ struct bfTransform
   Quaternionf world_rotation;      /*!< Cached rotation in world coordinates.                         */
   Vec3f       world_scale;         /*!< Cached scale in world coordinates.                            */
   Mat4x4      world_transform;     /*!< Cached matrix representing the world transform.               */
-  Mat4x4      inv_world_transform; /*!< Cached matrix representing the inverse world transform.       */
-  Mat4x4      normal_transform;    /*!< The inverse transpose of `world_transform`.                   */
 
   /* Local Transform */
   Vec3f       origin;          /*!< The pivot point from which the entity will rotate and scale from. */
   Vec3f       local_position;  /*!< Position relative to parent coordinate system.                    */
   Quaternionf local_rotation;  /*!< Rotation relative to parent coordinate system.                    */
   Vec3f       local_scale;     /*!< Scale relative to parent coordinate system.                       */
-  Mat4x4      local_transform; /*!< Cached matrix representing the local transform.                   */
 
   /* Hierarchy */
   bfTransform* parent;       /*!< Parent transform object.                                            */
@@ -147,8 +153,24 @@ BF_MATH_API void bfTransform_setScale(bfTransform* self, const Vec3f* value);
 BF_MATH_API void bfTransform_setParent(bfTransform* self, bfTransform* value);
 BF_MATH_API void bfTransform_copyFrom(bfTransform* self, const bfTransform* value); /* Copies over the local values, parent relationships are unchanged. */
 BF_MATH_API void bfTransform_flushChanges(bfTransform* self);
+BF_MATH_API void bfTransform_setDeferredFlush(bfTransform* self, int value); /* Changing from deferred to immediate flushes any pending changes. */
+BF_MATH_API void bfTransform_flushDirtyList(bfTransform** dirty_list);       /* Updates every transform with pending changes, parents before children. */
+BF_MATH_API void bfTransform_inverseWorldMatrix(const bfTransform* self, Mat4x4* out_inverse);
+BF_MATH_API void bfTransform_normalMatrix(const bfTransform* self, Mat4x4* out_normal); /* The inverse transpose of `world_transform`. */
 BF_MATH_API void bfTransform_dtor(bfTransform* self);
 
+/*
+  Building blocks of 'bfTransform_flushDirtyList' for flushing on multiple threads:
+
+    'bfTransform_takePendingRoots' unlinks the topmost pending transforms from the list and returns them
+    linked through `dirty_list_next`. Their subtrees are disjoint so each may be flushed on a different
+    thread with 'bfTransform_flushSubtree' as long as each thread adds to its own `dirty_list`.
+    Every returned root must be flushed before the next call.
+*/
+BF_MATH_API bfTransform* bfTransform_takePendingRoots(bfTransform** dirty_list);
+BF_MATH_API void         bfTransform_flushSubtree(bfTransform* self, bfTransform** dirty_list); /* 'bfTransform_flushChanges' but the updated transforms are added to `dirty_list`. */
+BF_MATH_API size_t       bfTransform_subtreeSize(const bfTransform* self);
+
 #if __cplusplus
 }
 #endif
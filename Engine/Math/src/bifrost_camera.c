@@ -1,6 +1,14 @@
 #include "bf/math/bifrost_camera.h"
 
-#include <math.h> /* cosf, sinf */
+#include <math.h>   /* cosf, sinf */
+#include <string.h> /* memset     */
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define BF_FRUSTUM_CULL_SSE 1
+#include <xmmintrin.h>
+#else
+#define BF_FRUSTUM_CULL_SSE 0
+#endif
 
 /* Camera API */
 
@@ -447,6 +455,109 @@ bfFrustumTestResult bfFrustum_isAABBInside(const bfFrustum* self, Vec3f aabb_min
   return result;
 }
 
+// The positive vertex of the AABB is the corner furthest along the plane's normal,
+// if it is behind the plane then the whole AABB is.
+// Since the sign of the normal is the same for every AABB the
+// corner is picked by selecting between the min and max arrays once per plane.
+
+typedef struct bfFrustumCullPlane
+{
+  const float* px;
+  const float* py;
+  const float* pz;
+  bfPlane      plane;
+
+} bfFrustumCullPlane;
+
+static void frustum_cull_planes(const bfFrustum* self, const bfAABBSoA* aabbs, bfFrustumCullPlane out_planes[k_bfPlaneIdx_Max])
+{
+  for (int i = 0; i < k_bfPlaneIdx_Max; ++i)
+  {
+    const bfPlane plane = self->planes[i];
+
+    out_planes[i].px    = plane.nx >= 0.0f ? aabbs->max_x : aabbs->min_x;
+    out_planes[i].py    = plane.ny >= 0.0f ? aabbs->max_y : aabbs->min_y;
+    out_planes[i].pz    = plane.nz >= 0.0f ? aabbs->max_z : aabbs->min_z;
+    out_planes[i].plane = plane;
+  }
+}
+
+static int frustum_cull_is_visible(const bfFrustumCullPlane planes[k_bfPlaneIdx_Max], size_t index)
+{
+  for (int i = 0; i < k_bfPlaneIdx_Max; ++i)
+  {
+    const bfFrustumCullPlane* const p        = planes + i;
+    const float                     distance = p->plane.nx * p->px[index] + p->plane.ny * p->py[index] + p->plane.nz * p->pz[index] - p->plane.d;
+
+    if (distance < 0.0f)
+    {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+void bfFrustum_cullAABBs(const bfFrustum* self, const bfAABBSoA* aabbs, uint32_t* out_visible_bits)
+{
+  const size_t       num_aabbs = aabbs->num_aabbs;
+  bfFrustumCullPlane planes[k_bfPlaneIdx_Max];
+  size_t             i = 0;
+
+  frustum_cull_planes(self, aabbs, planes);
+
+  memset(out_visible_bits, 0x0, sizeof(uint32_t) * ((num_aabbs + 31) / 32));
+
+#if BF_FRUSTUM_CULL_SSE
+  {
+    __m128 plane_nx[k_bfPlaneIdx_Max];
+    __m128 plane_ny[k_bfPlaneIdx_Max];
+    __m128 plane_nz[k_bfPlaneIdx_Max];
+    __m128 plane_d[k_bfPlaneIdx_Max];
+
+    for (int p = 0; p < k_bfPlaneIdx_Max; ++p)
+    {
+      plane_nx[p] = _mm_set1_ps(planes[p].plane.nx);
+      plane_ny[p] = _mm_set1_ps(planes[p].plane.ny);
+      plane_nz[p] = _mm_set1_ps(planes[p].plane.nz);
+      plane_d[p]  = _mm_set1_ps(planes[p].plane.d);
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+
+    for (; i + 4 <= num_aabbs; i += 4)
+    {
+      __m128 is_outside = zero;
+
+      for (int p = 0; p < k_bfPlaneIdx_Max; ++p)
+      {
+        const __m128 px       = _mm_loadu_ps(planes[p].px + i);
+        const __m128 py       = _mm_loadu_ps(planes[p].py + i);
+        const __m128 pz       = _mm_loadu_ps(planes[p].pz + i);
+        const __m128 distance = _mm_sub_ps(
+         _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane_nx[p], px), _mm_mul_ps(plane_ny[p], py)), _mm_mul_ps(plane_nz[p], pz)),
+         plane_d[p]);
+
+        is_outside = _mm_or_ps(is_outside, _mm_cmplt_ps(distance, zero));
+      }
+
+      // `i` is a multiple of 4 here so the 4 bits never straddle two words.
+      const uint32_t visible_mask = (uint32_t)(~_mm_movemask_ps(is_outside) & 0xF);
+
+      out_visible_bits[i / 32] |= visible_mask << (i % 32);
+    }
+  }
+#endif
+
+  for (; i < num_aabbs; ++i)
+  {
+    if (frustum_cull_is_visible(planes, i))
+    {
+      out_visible_bits[i / 32] |= 1u << (i % 32);
+    }
+  }
+}
+
 /* Ray API */
 
 enum
@@ -16,6 +16,13 @@
 #include <xmmintrin.h>
 #endif
 
+#if !MATRIX_ROW_MAJOR && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define BF_MAT4X4_AFFINE_SSE 1
+#include <xmmintrin.h>
+#else
+#define BF_MAT4X4_AFFINE_SSE 0
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159f
 #endif
@@ -493,6 +500,61 @@ int Mat4x4_inverse(const Mat4x4* self, Mat4x4* outInverse)
   return 1;
 }
 
+int Mat4x4_inverseAffine(const Mat4x4* self, Mat4x4* outInverse)
+{
+  // Inverse of [A t] is [A^-1 -A^-1 * t] where A is the upper 3x3.
+
+  const float a00 = Mat4x4_at(self, 0, 0), a01 = Mat4x4_at(self, 1, 0), a02 = Mat4x4_at(self, 2, 0);
+  const float a10 = Mat4x4_at(self, 0, 1), a11 = Mat4x4_at(self, 1, 1), a12 = Mat4x4_at(self, 2, 1);
+  const float a20 = Mat4x4_at(self, 0, 2), a21 = Mat4x4_at(self, 1, 2), a22 = Mat4x4_at(self, 2, 2);
+  const float tx  = Mat4x4_at(self, 3, 0);
+  const float ty  = Mat4x4_at(self, 3, 1);
+  const float tz  = Mat4x4_at(self, 3, 2);
+
+  const float c00 = a11 * a22 - a12 * a21;
+  const float c01 = a12 * a20 - a10 * a22;
+  const float c02 = a10 * a21 - a11 * a20;
+
+  float det = a00 * c00 + a01 * c01 + a02 * c02;
+
+  if (det == 0.0f)
+    return 0;
+
+  det = 1.0f / det;
+
+  const float i00 = c00 * det;
+  const float i01 = (a02 * a21 - a01 * a22) * det;
+  const float i02 = (a01 * a12 - a02 * a11) * det;
+  const float i10 = c01 * det;
+  const float i11 = (a00 * a22 - a02 * a20) * det;
+  const float i12 = (a02 * a10 - a00 * a12) * det;
+  const float i20 = c02 * det;
+  const float i21 = (a01 * a20 - a00 * a21) * det;
+  const float i22 = (a00 * a11 - a01 * a10) * det;
+
+  *Mat4x4_get(outInverse, 0, 0) = i00;
+  *Mat4x4_get(outInverse, 1, 0) = i01;
+  *Mat4x4_get(outInverse, 2, 0) = i02;
+  *Mat4x4_get(outInverse, 3, 0) = -(i00 * tx + i01 * ty + i02 * tz);
+
+  *Mat4x4_get(outInverse, 0, 1) = i10;
+  *Mat4x4_get(outInverse, 1, 1) = i11;
+  *Mat4x4_get(outInverse, 2, 1) = i12;
+  *Mat4x4_get(outInverse, 3, 1) = -(i10 * tx + i11 * ty + i12 * tz);
+
+  *Mat4x4_get(outInverse, 0, 2) = i20;
+  *Mat4x4_get(outInverse, 1, 2) = i21;
+  *Mat4x4_get(outInverse, 2, 2) = i22;
+  *Mat4x4_get(outInverse, 3, 2) = -(i20 * tx + i21 * ty + i22 * tz);
+
+  *Mat4x4_get(outInverse, 0, 3) = 0.0f;
+  *Mat4x4_get(outInverse, 1, 3) = 0.0f;
+  *Mat4x4_get(outInverse, 2, 3) = 0.0f;
+  *Mat4x4_get(outInverse, 3, 3) = 1.0f;
+
+  return 1;
+}
+
 static float det_2x2(float a, float b, float c, float d)
 {
   return (a * d) - (b * c);
@@ -626,6 +688,58 @@ void Mat4x4_mult(const Mat4x4* self, const Mat4x4* other, Mat4x4* out)
 #endif
 }
 
+void Mat4x4_multAffine(const Mat4x4* self, const Mat4x4* other, Mat4x4* out)
+{
+  // NOTE(SR):
+  //   Column i of the result is `self * other.column[i]`, since the bottom row of `other`
+  //   is [0, 0, 0, 1] only the translation column picks up `self`'s translation.
+  //   27 multiplies and 21 adds vs 64 and 48 for 'Mat4x4_mult'.
+
+#if BF_MAT4X4_AFFINE_SSE
+  const __m128 lhs_col_0 = _mm_loadu_ps(self->data + 0);
+  const __m128 lhs_col_1 = _mm_loadu_ps(self->data + 4);
+  const __m128 lhs_col_2 = _mm_loadu_ps(self->data + 8);
+  const __m128 lhs_col_3 = _mm_loadu_ps(self->data + 12);
+  __m128       result[4];
+
+  for (int i = 0; i < 4; ++i)
+  {
+    const float* const rhs_col = other->data + i * 4;
+
+    result[i] = _mm_add_ps(
+     _mm_add_ps(_mm_mul_ps(lhs_col_0, _mm_set1_ps(rhs_col[0])), _mm_mul_ps(lhs_col_1, _mm_set1_ps(rhs_col[1]))),
+     _mm_mul_ps(lhs_col_2, _mm_set1_ps(rhs_col[2])));
+  }
+
+  result[3] = _mm_add_ps(result[3], lhs_col_3);
+
+  for (int i = 0; i < 4; ++i)
+  {
+    _mm_storeu_ps(out->data + i * 4, result[i]);
+  }
+#else
+  Mat4x4 result;
+
+  for (int col = 0; col < 4; ++col)
+  {
+    for (int row = 0; row < 3; ++row)
+    {
+      *Mat4x4_get(&result, col, row) = Mat4x4_at(self, 0, row) * Mat4x4_at(other, col, 0) +
+                                       Mat4x4_at(self, 1, row) * Mat4x4_at(other, col, 1) +
+                                       Mat4x4_at(self, 2, row) * Mat4x4_at(other, col, 2);
+    }
+
+    *Mat4x4_get(&result, col, 3) = col == 3 ? 1.0f : 0.0f;
+  }
+
+  *Mat4x4_get(&result, 3, 0) += Mat4x4_at(self, 3, 0);
+  *Mat4x4_get(&result, 3, 1) += Mat4x4_at(self, 3, 1);
+  *Mat4x4_get(&result, 3, 2) += Mat4x4_at(self, 3, 2);
+
+  *out = result;
+#endif
+}
+
 void Mat4x4_multVec(const Mat4x4* self, const Vec3f* vec, Vec3f* outVec)
 {
 #if MATRIX_SSE
@@ -9,7 +9,6 @@
  */
 #include "bf/math/bifrost_transform.h"
 
-#include <assert.h>  // assert
 #include <math.h>    // sqrt
 #include <stddef.h>  // NULL
 
@@ -411,6 +410,8 @@ quat RotateTowards(quat q1, quat q2, float maxAngle)
 
 // Transform
 
+static void bfTransform_onLocalChanged(bfTransform* self, uint32_t dirty_flags);
+
 void bfTransform_ctor(bfTransform* self, bfTransform** dirty_list)
 {
   Vec3f_set(&self->origin, 0.0f, 0.0f, 0.0f, 1.0f);
@@ -420,7 +421,6 @@ void bfTransform_ctor(bfTransform* self, bfTransform** dirty_list)
   Vec3f_set(&self->world_position, 0.0f, 0.0f, 0.0f, 1.0f);
   self->world_rotation = bfQuaternionf_identity();
   Vec3f_set(&self->world_scale, 1.0f, 1.0f, 1.0f, 0.0f);
-  Mat4x4_identity(&self->local_transform);
   Mat4x4_identity(&self->world_transform);
   self->parent          = NULL;
   self->first_child     = NULL;
@@ -428,50 +428,33 @@ void bfTransform_ctor(bfTransform* self, bfTransform** dirty_list)
   self->prev_sibling    = NULL;
   self->dirty_list      = dirty_list;
   self->dirty_list_next = NULL;
+  self->flags           = BF_TRANSFORM_NONE;
   bfTransform_flushChanges(self);
-  self->flags = BF_TRANSFORM_DIRTY;
+  self->flags = BF_TRANSFORM_DIRTY | (self->flags & BF_TRANSFORM_IN_DIRTY_LIST);
 }
 
 void bfTransform_setOrigin(bfTransform* self, const Vec3f* value)
 {
   self->origin = *value;
-  bfTransform_flushChanges(self);
-  self->flags |= BF_TRANSFORM_ORIGIN_DIRTY;
-}
-
-/*
-Vec3f bfTransform_localPosition(const bfTransform* self)
-{
-  Vec3f result;
-
-  result.x = Mat4x4_at(&self->local_transform, 3, 0);
-  result.y = Mat4x4_at(&self->local_transform, 3, 1);
-  result.z = Mat4x4_at(&self->local_transform, 3, 2);
-  result.w = 1.0f;
-
-  return result;
+  bfTransform_onLocalChanged(self, BF_TRANSFORM_ORIGIN_DIRTY);
 }
-*/
 
 void bfTransform_setPosition(bfTransform* self, const Vec3f* value)
 {
   self->local_position = *value;
-  bfTransform_flushChanges(self);
-  self->flags |= BF_TRANSFORM_POSITION_DIRTY;
+  bfTransform_onLocalChanged(self, BF_TRANSFORM_POSITION_DIRTY);
 }
 
 void bfTransform_setRotation(bfTransform* self, const Quaternionf* value)
 {
   self->local_rotation = *value;
-  bfTransform_flushChanges(self);
-  self->flags |= BF_TRANSFORM_ROTATION_DIRTY;
+  bfTransform_onLocalChanged(self, BF_TRANSFORM_ROTATION_DIRTY);
 }
 
 void bfTransform_setScale(bfTransform* self, const Vec3f* value)
 {
   self->local_scale = *value;
-  bfTransform_flushChanges(self);
-  self->flags |= BF_TRANSFORM_SCALE_DIRTY;
+  bfTransform_onLocalChanged(self, BF_TRANSFORM_SCALE_DIRTY);
 }
 
 void bfTransform_setParent(bfTransform* self, bfTransform* value)
@@ -515,8 +498,7 @@ void bfTransform_setParent(bfTransform* self, bfTransform* value)
     }
 
     self->parent = value;
-    bfTransform_flushChanges(self);
-    self->flags |= BF_TRANSFORM_PARENT_DIRTY;
+    bfTransform_onLocalChanged(self, BF_TRANSFORM_PARENT_DIRTY);
   }
 }
 
@@ -529,110 +511,332 @@ void bfTransform_copyFrom(bfTransform* self, const bfTransform* value)
     self->local_rotation = value->local_rotation;
     self->local_scale    = value->local_scale;
 
-    bfTransform_flushChanges(self);
-    self->flags |= BF_TRANSFORM_LOCAL_DIRTY;
+    bfTransform_onLocalChanged(self, BF_TRANSFORM_LOCAL_DIRTY);
   }
 }
 
-static void bfTransform_flushMatrix(Mat4x4* out, const Vec3f origin, const Vec3f position, const Quaternionf rotation, const Vec3f scale)
+static void bfTransform_flushMatrix(Mat4x4* out, const Vec3f origin, const Vec3f position, Quaternionf rotation, const Vec3f scale)
 {
-  Mat4x4 translation_mat;
-  Mat4x4 rotation_mat;
-  Mat4x4 scale_mat;
-  Mat4x4 origin_mat;
-  Vec3f  total_translation;
+  // NOTE(SR):
+  //   Same as `Translate(position + origin) * Rotate(rotation) * Scale(scale) * Translate(-origin)`
+  //   but written out directly since each of those only touches part of the matrix:
+  //     - The upper 3x3 is the rotation matrix with each column multiplied by the scale on that axis.
+  //     - The translation is `position + origin - (upper 3x3 * origin)`.
 
-  total_translation = position;
-  Vec3f_add(&total_translation, &origin);
+  bfQuaternionf_normalize(&rotation);
 
-  Mat4x4_initTranslatef(&translation_mat, total_translation.x, total_translation.y, total_translation.z);
-  bfQuaternionf_toMatrix(rotation, &rotation_mat);
-  Mat4x4_initScalef(&scale_mat, scale.x, scale.y, scale.z);
-  Mat4x4_initTranslatef(&origin_mat, -origin.x, -origin.y, -origin.z);
+  const float qx = rotation.x;
+  const float qy = rotation.y;
+  const float qz = rotation.z;
+  const float qw = rotation.w;
+  const float xx = qx * qx;
+  const float yy = qy * qy;
+  const float zz = qz * qz;
+  const float xy = qx * qy;
+  const float xz = qx * qz;
+  const float yz = qy * qz;
+  const float wx = qw * qx;
+  const float wy = qw * qy;
+  const float wz = qw * qz;
 
-  // TODO(SR):
-  //   Multiplication by the `translation_mat` can probably be optimized
-  //   since it always just adds (/ sets) the translation part of the matrix.
-  //
-  //   This overall can be optimized since `scale_mat` and `origin_mat` operate of diff parts of the matrix.
-  //
-  //  This info is kinda wrong but there ARE optimizations to be made.
+  const float m00 = (1.0f - 2.0f * (yy + zz)) * scale.x;
+  const float m01 = (2.0f * (xy + wz)) * scale.x;
+  const float m02 = (2.0f * (xz - wy)) * scale.x;
+
+  const float m10 = (2.0f * (xy - wz)) * scale.y;
+  const float m11 = (1.0f - 2.0f * (xx + zz)) * scale.y;
+  const float m12 = (2.0f * (yz + wx)) * scale.y;
 
-  Mat4x4_mult(&scale_mat, &origin_mat, out);
-  Mat4x4_mult(&rotation_mat, out, out);
-  Mat4x4_mult(&translation_mat, out, out);
+  const float m20 = (2.0f * (xz + wy)) * scale.z;
+  const float m21 = (2.0f * (yz - wx)) * scale.z;
+  const float m22 = (1.0f - 2.0f * (xx + yy)) * scale.z;
+
+  *Mat4x4_get(out, 0, 0) = m00;
+  *Mat4x4_get(out, 0, 1) = m01;
+  *Mat4x4_get(out, 0, 2) = m02;
+  *Mat4x4_get(out, 0, 3) = 0.0f;
+
+  *Mat4x4_get(out, 1, 0) = m10;
+  *Mat4x4_get(out, 1, 1) = m11;
+  *Mat4x4_get(out, 1, 2) = m12;
+  *Mat4x4_get(out, 1, 3) = 0.0f;
+
+  *Mat4x4_get(out, 2, 0) = m20;
+  *Mat4x4_get(out, 2, 1) = m21;
+  *Mat4x4_get(out, 2, 2) = m22;
+  *Mat4x4_get(out, 2, 3) = 0.0f;
+
+  *Mat4x4_get(out, 3, 0) = position.x + origin.x - (m00 * origin.x + m10 * origin.y + m20 * origin.z);
+  *Mat4x4_get(out, 3, 1) = position.y + origin.y - (m01 * origin.x + m11 * origin.y + m21 * origin.z);
+  *Mat4x4_get(out, 3, 2) = position.z + origin.z - (m02 * origin.x + m12 * origin.y + m22 * origin.z);
+  *Mat4x4_get(out, 3, 3) = 1.0f;
 }
 
-void bfTransform_flushChanges(bfTransform* self)
+static void bfTransform_addToDirtyList(bfTransform* self, bfTransform** dirty_list)
 {
-  bfTransform* work_stack[k_TransformQueueStackMax] = {NULL}; /* TODO(SR): Make this dynamically sized? */
-  int          work_stack_top                       = 0;
-
-  work_stack[work_stack_top++] = self;
+  if ((self->flags & BF_TRANSFORM_IN_DIRTY_LIST) == 0u)
+  {
+    self->dirty_list_next = *dirty_list;
+    *dirty_list           = self;
+    self->flags |= BF_TRANSFORM_IN_DIRTY_LIST;
+  }
+}
 
-  while (work_stack_top)
+static void bfTransform_removeFromDirtyList(bfTransform* self)
+{
+  if (self->flags & BF_TRANSFORM_IN_DIRTY_LIST)
   {
-    bfTransform*       node        = work_stack[--work_stack_top];
-    const bfTransform* node_parent = node->parent;
-    bfTransform*       child       = node->first_child;
-
-    bfTransform_flushMatrix(
-     &node->local_transform,
-     node->origin,
-     node->local_position,
-     node->local_rotation,
-     node->local_scale);
-
-    if (node_parent)
+    bfTransform** link = self->dirty_list;
+
+    while (*link != self)
     {
-      const Mat4x4* const parent_mat = &node_parent->world_transform;
+      link = &(*link)->dirty_list_next;
+    }
 
-      Mat4x4_mult(parent_mat, &node->local_transform, &node->world_transform);
+    *link                 = self->dirty_list_next;
+    self->dirty_list_next = NULL;
+    self->flags &= ~(BF_TRANSFORM_IN_DIRTY_LIST | BF_TRANSFORM_FLUSH_PENDING);
+  }
+}
 
-      Mat4x4_multVec(parent_mat, &node->local_position, &node->world_position);
-      node->world_rotation = bfQuaternionf_multQ(&node_parent->world_rotation, &node->local_rotation);
-      node->world_scale    = node->local_scale;
-      Vec3f_multV(&node->world_scale, &node_parent->world_scale);
-    }
-    else
+static void bfTransform_flushNode(bfTransform* node, bfTransform** dirty_list)
+{
+  const bfTransform* node_parent = node->parent;
+  Mat4x4             local_transform;
+
+  bfTransform_flushMatrix(
+   &local_transform,
+   node->origin,
+   node->local_position,
+   node->local_rotation,
+   node->local_scale);
+
+  if (node_parent)
+  {
+    const Mat4x4* const parent_mat = &node_parent->world_transform;
+
+    Mat4x4_multAffine(parent_mat, &local_transform, &node->world_transform);
+
+    Mat4x4_multVec(parent_mat, &node->local_position, &node->world_position);
+    node->world_rotation = bfQuaternionf_multQ(&node_parent->world_rotation, &node->local_rotation);
+    node->world_scale    = node->local_scale;
+    Vec3f_multV(&node->world_scale, &node_parent->world_scale);
+  }
+  else
+  {
+    node->world_position  = node->local_position;
+    node->world_rotation  = node->local_rotation;
+    node->world_scale     = node->local_scale;
+    node->world_transform = local_transform;
+  }
+
+  bfTransform_addToDirtyList(node, dirty_list);
+
+  node->flags |= BF_TRANSFORM_NEEDS_GPU_UPLOAD;
+  node->flags &= ~(BF_TRANSFORM_FLUSH_PENDING | BF_TRANSFORM_PENDING_PARENT);
+}
+
+//
+// Pre-order walk of the subtree using the sibling and parent
+// links so that wide or deep hierarchies need no extra storage.
+//
+static bfTransform* bfTransform_nextSkippingChildren(const bfTransform* root, bfTransform* node)
+{
+  while (node != root && !node->next_sibling)
+  {
+    node = node->parent;
+  }
+
+  return node != root ? node->next_sibling : NULL;
+}
+
+static bfTransform* bfTransform_nextInSubtree(const bfTransform* root, bfTransform* node)
+{
+  return node->first_child ? node->first_child : bfTransform_nextSkippingChildren(root, node);
+}
+
+void bfTransform_flushChanges(bfTransform* self)
+{
+  bfTransform_flushSubtree(self, self->dirty_list);
+}
+
+void bfTransform_flushSubtree(bfTransform* self, bfTransform** dirty_list)
+{
+  bfTransform* node = self;
+
+  while (node)
+  {
+    bfTransform_flushNode(node, dirty_list);
+
+    if (node != self)
     {
-      node->world_position  = node->local_position;
-      node->world_rotation  = node->local_rotation;
-      node->world_scale     = node->local_scale;
-      node->world_transform = node->local_transform;
+      node->flags |= BF_TRANSFORM_PARENT_DIRTY;
     }
 
-    if (Mat4x4_inverse(&node->world_transform, &node->inv_world_transform))
+    node = bfTransform_nextInSubtree(self, node);
+  }
+}
+
+size_t bfTransform_subtreeSize(const bfTransform* self)
+{
+  size_t       result = 0;
+  bfTransform* node   = (bfTransform*)self;
+
+  while (node)
+  {
+    ++result;
+    node = bfTransform_nextInSubtree(self, node);
+  }
+
+  return result;
+}
+
+void bfTransform_setDeferredFlush(bfTransform* self, int value)
+{
+  if (value)
+  {
+    self->flags |= BF_TRANSFORM_DEFER_FLUSH;
+  }
+  else
+  {
+    self->flags &= ~BF_TRANSFORM_DEFER_FLUSH;
+
+    if (self->flags & BF_TRANSFORM_FLUSH_PENDING)
     {
-      node->normal_transform = node->inv_world_transform;
-      Mat4x4_transpose(&node->normal_transform);
+      bfTransform_flushChanges(self);
     }
+  }
+}
+
+//
+// Flags every descendant of `self` with `BF_TRANSFORM_PENDING_PARENT`.
+// Descendants that were already taken as roots have flagged their own
+// subtree so only they are flagged, this way each transform is visited once.
+//
+static void bfTransform_markPendingSubtree(bfTransform* self)
+{
+  bfTransform* node = self->first_child;
+
+  while (node)
+  {
+    const int is_taken_root = (node->flags & (BF_TRANSFORM_FLUSH_PENDING | BF_TRANSFORM_IN_DIRTY_LIST)) == BF_TRANSFORM_FLUSH_PENDING;
 
-    while (child)
+    node->flags |= BF_TRANSFORM_PENDING_PARENT;
+
+    node = is_taken_root ? bfTransform_nextSkippingChildren(self, node) : bfTransform_nextInSubtree(self, node);
+  }
+}
+
+bfTransform* bfTransform_takePendingRoots(bfTransform** dirty_list)
+{
+  bfTransform* node         = *dirty_list;
+  bfTransform* pending_list = NULL;
+  bfTransform* result       = NULL;
+
+  *dirty_list = NULL;
+
+  // NOTE(SR):
+  //   Every pending transform not already below another one is taken out of the list and
+  //   has its subtree flagged with `BF_TRANSFORM_PENDING_PARENT`. A pending ancestor that
+  //   shows up later in the list flags over it, so the taken transforms still flagged
+  //   once the whole list is seen are the roots of the subtrees that need to be flushed.
+  //
+  //   Everything else stays in the list, flushing a subtree does not add a transform twice.
+  //
+  //   This way each transform is only recomputed once no matter how many
+  //   times it or its parents were changed since the last flush.
+
+  while (node)
+  {
+    bfTransform* const next = node->dirty_list_next;
+
+    if ((node->flags & (BF_TRANSFORM_FLUSH_PENDING | BF_TRANSFORM_PENDING_PARENT)) == BF_TRANSFORM_FLUSH_PENDING)
     {
-      assert(work_stack_top < k_TransformQueueStackMax);
+      node->dirty_list_next = pending_list;
+      pending_list          = node;
+      node->flags &= ~BF_TRANSFORM_IN_DIRTY_LIST;
 
-      work_stack[work_stack_top++] = child;
-      child                        = child->next_sibling;
+      bfTransform_markPendingSubtree(node);
     }
-
-    // This the node was not dirty before then prepend to the dirty list.
-    if ((node->flags & BF_TRANSFORM_LOCAL_DIRTY) == 0u)
+    else
     {
-      node->dirty_list_next = *node->dirty_list;
-      *node->dirty_list     = node;
+      node->dirty_list_next = *dirty_list;
+      *dirty_list           = node;
     }
 
-    node->flags |= BF_TRANSFORM_NEEDS_GPU_UPLOAD;
+    node = next;
+  }
 
-    if (node != self)
+  while (pending_list)
+  {
+    bfTransform* const next = pending_list->dirty_list_next;
+
+    if (pending_list->flags & BF_TRANSFORM_PENDING_PARENT)
     {
-      node->flags |= BF_TRANSFORM_PARENT_DIRTY;
+      pending_list->dirty_list_next = NULL;
     }
+    else
+    {
+      pending_list->dirty_list_next = result;
+      result                        = pending_list;
+    }
+
+    pending_list = next;
+  }
+
+  return result;
+}
+
+void bfTransform_flushDirtyList(bfTransform** dirty_list)
+{
+  bfTransform* pending_roots = bfTransform_takePendingRoots(dirty_list);
+
+  while (pending_roots)
+  {
+    bfTransform* const next = pending_roots->dirty_list_next;
+
+    pending_roots->dirty_list_next = NULL;
+
+    bfTransform_flushSubtree(pending_roots, dirty_list);
+
+    pending_roots = next;
   }
 }
 
+static void bfTransform_onLocalChanged(bfTransform* self, uint32_t dirty_flags)
+{
+  if (self->flags & BF_TRANSFORM_DEFER_FLUSH)
+  {
+    bfTransform_addToDirtyList(self, self->dirty_list);
+    self->flags |= BF_TRANSFORM_FLUSH_PENDING;
+  }
+  else
+  {
+    bfTransform_flushChanges(self);
+  }
+
+  self->flags |= dirty_flags;
+}
+
+void bfTransform_inverseWorldMatrix(const bfTransform* self, Mat4x4* out_inverse)
+{
+  // NOTE(SR):
+  //   A chain of TRS matrices is always affine, a zero scale has no inverse.
+
+  if (!Mat4x4_inverseAffine(&self->world_transform, out_inverse))
+  {
+    Mat4x4_identity(out_inverse);
+  }
+}
+
+void bfTransform_normalMatrix(const bfTransform* self, Mat4x4* out_normal)
+{
+  bfTransform_inverseWorldMatrix(self, out_normal);
+  Mat4x4_transpose(out_normal);
+}
+
 void bfTransform_dtor(bfTransform* self)
 {
   bfTransform_setParent(self, NULL);
+  bfTransform_removeFromDirtyList(self);
 }
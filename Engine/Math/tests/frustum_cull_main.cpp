@@ -0,0 +1,132 @@
+//
+// Benchmark of culling a flat list of AABBs one at a time with
+// `bfFrustum_isAABBInside` vs in one batch with `bfFrustum_cullAABBs`.
+//
+#include "bf/math/bifrost_camera.h"
+
+#include <algorithm>  // fill
+#include <chrono>     // steady_clock
+#include <cstdint>    // uint32_t
+#include <cstdio>     // printf
+#include <random>     // mt19937, uniform_real_distribution
+#include <vector>     // vector
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr std::size_t k_NumBoxes[]  = {1000u, 10000u, 100000u, 1000000u};
+static constexpr int         k_NumRepeats = 20;
+
+struct BoxList
+{
+  std::vector<float> min_x, min_y, min_z;
+  std::vector<float> max_x, max_y, max_z;
+
+  explicit BoxList(std::size_t num_boxes) :
+    min_x(num_boxes),
+    min_y(num_boxes),
+    min_z(num_boxes),
+    max_x(num_boxes),
+    max_y(num_boxes),
+    max_z(num_boxes)
+  {
+    std::mt19937                          rng{1234u};
+    std::uniform_real_distribution<float> position{-200.0f, 200.0f};
+    std::uniform_real_distribution<float> half_extent{0.1f, 4.0f};
+
+    for (std::size_t i = 0; i < num_boxes; ++i)
+    {
+      const float x = position(rng), y = position(rng), z = position(rng);
+      const float e = half_extent(rng);
+
+      min_x[i] = x - e;
+      min_y[i] = y - e;
+      min_z[i] = z - e;
+      max_x[i] = x + e;
+      max_y[i] = y + e;
+      max_z[i] = z + e;
+    }
+  }
+
+  bfAABBSoA soa() const
+  {
+    return {min_x.data(), min_y.data(), min_z.data(), max_x.data(), max_y.data(), max_z.data(), min_x.size()};
+  }
+};
+
+template<typename F>
+static double boxesPerSecond(std::size_t num_boxes, F&& fn)
+{
+  const Clock::time_point start = Clock::now();
+
+  for (int i = 0; i < k_NumRepeats; ++i)
+  {
+    fn();
+  }
+
+  const std::chrono::duration<double> elapsed = Clock::now() - start;
+
+  return double(num_boxes) * k_NumRepeats / elapsed.count();
+}
+
+static std::size_t countBits(const std::vector<std::uint32_t>& bits)
+{
+  std::size_t count = 0u;
+
+  for (std::uint32_t word : bits)
+  {
+    for (; word; word &= word - 1u)
+    {
+      ++count;
+    }
+  }
+
+  return count;
+}
+
+int main()
+{
+  Mat4x4    projection;
+  bfFrustum frustum;
+
+  Mat4x4_perspective(&projection, 60.0f, 16.0f / 9.0f, 0.1f, 150.0f);
+  bfFrustum_fromMatrix(&frustum, &projection);
+
+  std::printf("%10s | %14s | %15s | %7s | %s\n", "Boxes", "Scalar (box/s)", "Batched (box/s)", "Speedup", "Visible (scalar / batched)");
+
+  for (const std::size_t num_boxes : k_NumBoxes)
+  {
+    const BoxList              boxes{num_boxes};
+    const bfAABBSoA            soa = boxes.soa();
+    std::vector<std::uint32_t> scalar_bits((num_boxes + 31) / 32);
+    std::vector<std::uint32_t> batched_bits((num_boxes + 31) / 32);
+
+    const double scalar_rate = boxesPerSecond(num_boxes, [&]() {
+      std::fill(scalar_bits.begin(), scalar_bits.end(), 0u);
+
+      for (std::size_t i = 0; i < num_boxes; ++i)
+      {
+        const Vec3f box_min = {boxes.min_x[i], boxes.min_y[i], boxes.min_z[i], 1.0f};
+        const Vec3f box_max = {boxes.max_x[i], boxes.max_y[i], boxes.max_z[i], 1.0f};
+
+        if (bfFrustum_isAABBInside(&frustum, box_min, box_max) != BF_FRUSTUM_TEST_OUTSIDE)
+        {
+          scalar_bits[i / 32] |= 1u << (i % 32);
+        }
+      }
+    });
+
+    const double batched_rate = boxesPerSecond(num_boxes, [&]() {
+      bfFrustum_cullAABBs(&frustum, &soa, batched_bits.data());
+    });
+
+    std::printf("%10zu | %14.0f | %15.0f | %6.2fx | %zu / %zu\n",
+                num_boxes,
+                scalar_rate,
+                batched_rate,
+                batched_rate / scalar_rate,
+                countBits(scalar_bits),
+                countBits(batched_bits));
+  }
+
+  return 0;
+}
@@ -0,0 +1,186 @@
+//
+// Benchmark of flushing a large transform hierarchy, the old path built four
+// matrices per transform and multiplied them together with `Mat4x4_mult`,
+// the current one writes the TRS matrix directly and uses `Mat4x4_multAffine`.
+//
+#include "bf/math/bifrost_transform.h"
+
+#include <algorithm>  // max
+#include <chrono>     // steady_clock
+#include <cmath>      // fabs
+#include <cstdio>     // printf
+#include <random>     // mt19937, uniform_real_distribution
+#include <vector>     // vector
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr std::size_t k_NumTransforms = 100000u;
+static constexpr std::size_t k_FanOut        = 4u;
+static constexpr int         k_NumRepeats    = 20;
+
+// What `bfTransform_flushMatrix` did before it was written out by hand.
+static void oldFlushMatrix(Mat4x4* out, const bfTransform& transform)
+{
+  Mat4x4 translation_mat;
+  Mat4x4 rotation_mat;
+  Mat4x4 scale_mat;
+  Mat4x4 origin_mat;
+  Vec3f  total_translation = transform.local_position;
+
+  Vec3f_add(&total_translation, &transform.origin);
+
+  Mat4x4_initTranslatef(&translation_mat, total_translation.x, total_translation.y, total_translation.z);
+  bfQuaternionf_toMatrix(transform.local_rotation, &rotation_mat);
+  Mat4x4_initScalef(&scale_mat, transform.local_scale.x, transform.local_scale.y, transform.local_scale.z);
+  Mat4x4_initTranslatef(&origin_mat, -transform.origin.x, -transform.origin.y, -transform.origin.z);
+
+  Mat4x4_mult(&scale_mat, &origin_mat, out);
+  Mat4x4_mult(&rotation_mat, out, out);
+  Mat4x4_mult(&translation_mat, out, out);
+}
+
+static void clearDirtyList(bfTransform** dirty_list)
+{
+  while (*dirty_list)
+  {
+    bfTransform* const transform = *dirty_list;
+
+    *dirty_list                = transform->dirty_list_next;
+    transform->dirty_list_next = nullptr;
+    transform->flags &= ~(BF_TRANSFORM_IN_DIRTY_LIST | BF_TRANSFORM_FLUSH_PENDING);
+  }
+}
+
+template<typename F>
+static double averageMs(F&& fn)
+{
+  const Clock::time_point start = Clock::now();
+
+  for (int i = 0; i < k_NumRepeats; ++i)
+  {
+    fn();
+  }
+
+  const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+
+  return elapsed.count() / k_NumRepeats;
+}
+
+int main()
+{
+  std::vector<bfTransform>              transforms(k_NumTransforms);
+  std::vector<Mat4x4>                   old_world(k_NumTransforms);
+  bfTransform*                          dirty_list = nullptr;
+  std::mt19937                          rng{1234u};
+  std::uniform_real_distribution<float> position{-10.0f, 10.0f};
+  std::uniform_real_distribution<float> angle{-180.0f, 180.0f};
+  std::uniform_real_distribution<float> scale{0.5f, 1.5f};
+
+  // Parents always come before their children so the old path can go in index order.
+  for (std::size_t i = 0; i < k_NumTransforms; ++i)
+  {
+    bfTransform& transform = transforms[i];
+
+    bfTransform_ctor(&transform, &dirty_list);
+    bfTransform_setDeferredFlush(&transform, 1);
+
+    const Vec3f       local_position = {position(rng), position(rng), position(rng), 1.0f};
+    const Vec3f       origin         = {position(rng) * 0.1f, position(rng) * 0.1f, position(rng) * 0.1f, 1.0f};
+    const Vec3f       local_scale    = {scale(rng), scale(rng), scale(rng), 0.0f};
+    const Quaternionf local_rotation = bfQuaternionf_fromEulerDeg(angle(rng), angle(rng), angle(rng));
+
+    bfTransform_setPosition(&transform, &local_position);
+    bfTransform_setOrigin(&transform, &origin);
+    bfTransform_setScale(&transform, &local_scale);
+    bfTransform_setRotation(&transform, &local_rotation);
+
+    if (i != 0u)
+    {
+      bfTransform_setParent(&transform, &transforms[(i - 1u) / k_FanOut]);
+    }
+  }
+
+  bfTransform_flushDirtyList(&dirty_list);
+  clearDirtyList(&dirty_list);
+
+  const double old_ms = averageMs([&]() {
+    for (std::size_t i = 0; i < k_NumTransforms; ++i)
+    {
+      bfTransform& transform = transforms[i];
+      Mat4x4       local_transform;
+
+      oldFlushMatrix(&local_transform, transform);
+
+      if (i != 0u)
+      {
+        const std::size_t parent_index = (i - 1u) / k_FanOut;
+        const Mat4x4&     parent_mat   = old_world[parent_index];
+
+        Mat4x4_mult(&parent_mat, &local_transform, &old_world[i]);
+
+        Mat4x4_multVec(&parent_mat, &transform.local_position, &transform.world_position);
+        transform.world_rotation = bfQuaternionf_multQ(&transforms[parent_index].world_rotation, &transform.local_rotation);
+        transform.world_scale    = transform.local_scale;
+        Vec3f_multV(&transform.world_scale, &transforms[parent_index].world_scale);
+      }
+      else
+      {
+        old_world[i] = local_transform;
+      }
+    }
+  });
+
+  double new_ms = 0.0;
+
+  for (int i = 0; i < k_NumRepeats; ++i)
+  {
+    bfTransform_setPosition(&transforms[0], &transforms[0].local_position);
+
+    const Clock::time_point start = Clock::now();
+    bfTransform_flushDirtyList(&dirty_list);
+    new_ms += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    clearDirtyList(&dirty_list);
+  }
+
+  new_ms /= k_NumRepeats;
+
+  float max_relative_error = 0.0f;
+
+  for (std::size_t i = 0; i < k_NumTransforms; ++i)
+  {
+    for (int j = 0; j < 16; ++j)
+    {
+      const float expected = old_world[i].data[j];
+      const float actual   = transforms[i].world_transform.data[j];
+
+      max_relative_error = std::max(max_relative_error, std::fabs(expected - actual) / std::max(1.0f, std::fabs(expected)));
+    }
+  }
+
+  std::vector<Mat4x4> products(k_NumTransforms);
+
+  const double mult_ms = averageMs([&]() {
+    for (std::size_t i = 1; i < k_NumTransforms; ++i)
+    {
+      Mat4x4_mult(&transforms[i - 1].world_transform, &transforms[i].world_transform, &products[i]);
+    }
+  });
+
+  const double mult_affine_ms = averageMs([&]() {
+    for (std::size_t i = 1; i < k_NumTransforms; ++i)
+    {
+      Mat4x4_multAffine(&transforms[i - 1].world_transform, &transforms[i].world_transform, &products[i]);
+    }
+  });
+
+  std::printf("Flushing %zu transforms (fan out of %zu):\n", k_NumTransforms, k_FanOut);
+  std::printf("  Old (4 matrices + Mat4x4_mult) : %8.3f ms\n", old_ms);
+  std::printf("  New (direct TRS + multAffine)  : %8.3f ms\n", new_ms);
+  std::printf("  Max relative error             : %g\n", double(max_relative_error));
+  std::printf("%zu matrix products:\n", k_NumTransforms - 1u);
+  std::printf("  Mat4x4_mult                    : %8.3f ms\n", mult_ms);
+  std::printf("  Mat4x4_multAffine              : %8.3f ms\n", mult_affine_ms);
+
+  return max_relative_error < 1e-3f ? 0 : 1;
+}
@@ -1,6 +1,7 @@
 #ifndef BF_ANIMATION_SYSTEM
 #define BF_ANIMATION_SYSTEM
 
+#include "bf/asset_io/bf_gfx_assets.hpp"
 #include "bf/ecs/bifrost_iecs_system.hpp"
 #include "bf/graphics/bifrost_standard_renderer.hpp"
 
@@ -13,23 +14,59 @@ namespace bf
     Mat4x4 u_Bones[k_GfxMaxTotalBones];
   };
 
+  //
+  // The animation state of a single SkinnedMeshRenderer kept from frame to frame.
+  //
+  struct SkeletonInstance
+  {
+    Renderable<ObjectBoneData>        renderable;
+    const ModelAsset*                 model;                //!< The model `node_to_channel` and `node_transforms` are for.
+    const Anim3DAsset*                animation;            //!< The animation `key_cursors` and `channel_poses` are for.
+    Array<Anim3DAsset::ChannelCursor> key_cursors;          //!< One per channel of `animation`.
+    Array<Anim3DAsset::ChannelPose>   channel_poses;        //!< One per channel of `animation`, the pose sampled this frame.
+    Array<std::uint8_t>               node_to_channel;      //!< One per node of `model`, `k_InvalidBoneID` for nodes `animation` does not move.
+    Array<std::uint8_t>               node_lod_masks;       //!< One per node of `model`, bit `i` is set if the node is animated at LOD `i`.
+    Array<Matrix4x4f>                 node_transforms;      //!< One per node of `model`, the global transforms from the last update.
+    Array<Matrix4x4f>                 bone_palettes;        //!< The palette of the last full update followed by the next one, `model->numBones()` each.
+    std::uint8_t                      update_interval;      //!< Frames the next palette is blended in over, 0 before the first update.
+    std::uint8_t                      frames_since_update;  //!< Frames since the last full update.
+    std::uint8_t                      lod;                  //!< The LOD of the last full update.
+
+    explicit SkeletonInstance(IMemoryManager& memory) :
+      renderable{},
+      model{nullptr},
+      animation{nullptr},
+      key_cursors{memory},
+      channel_poses{memory},
+      node_to_channel{memory},
+      node_lod_masks{memory},
+      node_transforms{memory},
+      bone_palettes{memory},
+      update_interval{0u},
+      frames_since_update{0u},
+      lod{0u}
+    {
+    }
+  };
+
   class AnimationSystem final : public IECSSystem
   {
    private:
-    bfAnim2DCtx*                                    m_Anim2DCtx;
-    List<Renderable<ObjectBoneData>>                m_RenderablePool;  // TODO(SR): Per make this Scene.
-    HashTable<Entity*, Renderable<ObjectBoneData>*> m_Renderables;     // TODO(SR): Per make this Scene.
+    bfAnim2DCtx*                          m_Anim2DCtx;
+    List<SkeletonInstance>                m_SkeletonPool;  // TODO(SR): Per make this Scene.
+    HashTable<Entity*, SkeletonInstance*> m_Skeletons;     // TODO(SR): Per make this Scene.
 
    public:
     AnimationSystem(IMemoryManager& memory) :
       m_Anim2DCtx{nullptr},
-      m_RenderablePool{memory},
-      m_Renderables{}
+      m_SkeletonPool{memory},
+      m_Skeletons{}
     {
     }
 
     bfAnim2DCtx*                anim2DCtx() const { return m_Anim2DCtx; }
-    Renderable<ObjectBoneData>& getRenderable(StandardRenderer& renderer, Entity& entity);
+    SkeletonInstance&           getSkeleton(StandardRenderer& renderer, Entity& entity);
+    Renderable<ObjectBoneData>& getRenderable(StandardRenderer& renderer, Entity& entity) { return getSkeleton(renderer, entity).renderable; }
 
     void onInit(Engine& engine) override;
     void onFrameUpdate(Engine& engine, float dt) override;
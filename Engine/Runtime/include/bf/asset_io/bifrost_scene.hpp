@@ -49,12 +49,12 @@ namespace bf
     Engine&              m_Engine;  // TODO(SR): Remove this.
     IMemoryManager&      m_Memory;
     ListView<Entity>     m_RootEntities;
-    ComponentStorage     m_ActiveComponents;
-    ComponentStorage     m_InactiveComponents;
+    ComponentStorage     m_Components;
     Array<BaseBehavior*> m_ActiveBehaviors;
     BVH                  m_BVHTree;
     Camera               m_Camera;
     bfTransform*         m_DirtyList;
+    bool                 m_IsBulkLoading;
 
    public:
     explicit Scene(Engine& engine);
@@ -74,27 +74,54 @@ namespace bf
 
     const ListView<Entity>& rootEntities() const { return m_RootEntities; }
     EntityRef               addEntity(const StringRange& name = "Untitled");
+    std::size_t             addEntities(std::size_t num_entities, Entity** out_entities, const StringRange& name = "Untitled");
     EntityRef               findEntity(const StringRange& name) const;
     void                    removeEntity(Entity* entity);
+    void                    destroyEntities(Entity* const* entities, std::size_t num_entities);
     void                    removeAllEntities();
     BVH&                    bvh() { return m_BVHTree; }
+    void                    rebuildBVH(LinearAllocator& temp);
+
+    //
+    // While bulk loading renderers do not insert themselves into the BVH one at a time,
+    // `endBulkLoad` builds the whole tree once from every enabled renderer instead.
+    //
+    bool isBulkLoading() const { return m_IsBulkLoading; }
+    void beginBulkLoad();
+    void endBulkLoad(LinearAllocator& temp);
 
     void update(LinearAllocator& temp, DebugRenderer& dbg_renderer);
+    void flushTransforms();
 
     // Component
 
     template<typename T>
-    DenseMap<ComponentHandleImpl<T>>& components()
+    ComponentView<T> components()
     {
-      return m_ActiveComponents.get<ComponentHandleImpl<T>>();
+      return m_Components.view<T>();
     }
 
     template<typename T>
-    const DenseMap<ComponentHandleImpl<T>>& components() const
+    ComponentView<const T> components() const
     {
-      return m_ActiveComponents.get<ComponentHandleImpl<T>>();
+      return m_Components.view<const T>();
     }
 
+    //
+    // Iterates the active components of each entity that has all of `Ts`.
+    //
+    template<typename... Ts>
+    ComponentQuery<Ts...> query()
+    {
+      return m_Components.query<Ts...>();
+    }
+
+    //
+    // Holds both active and inactive components, only the
+    // active ones are enabled in views and queries.
+    //
+    const ComponentStorage& componentStorage() const { return m_Components; }
+
     // Behavior
 
     const Array<BaseBehavior*>& behaviors() const { return m_ActiveBehaviors; }
@@ -108,6 +135,7 @@ namespace bf
 
    private:
     void updateDirtyListTransforms();
+    void dropDestroyedFromDirtyList();
   };
 
   BIFROST_META_REGISTER(bf::Scene)
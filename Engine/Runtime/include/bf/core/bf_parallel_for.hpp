@@ -0,0 +1,119 @@
+/******************************************************************************/
+/*!
+ * @file   bf_parallel_for.hpp
+ * @author Shareef Abdoul-Raheem (http://blufedora.github.io/)
+ * @brief
+ *   Helpers for splitting a range of work across the job system.
+ *
+ *   Work is split into a fixed number of chunks and each chunk is told its
+ *   index so that callers can write into per chunk outputs and merge them
+ *   in order afterwards, making the result independent of scheduling.
+ *
+ *   `fn` is called from multiple threads at once so it may only write
+ *   to data owned by the item or chunk it was handed.
+ *
+ * @version 0.0.1
+ * @date    2021-03-14
+ *
+ * @copyright Copyright (c) 2021
+ */
+/******************************************************************************/
+#ifndef BF_PARALLEL_FOR_HPP
+#define BF_PARALLEL_FOR_HPP
+
+#include "bf/JobSystem.hpp"  // Job System
+
+#include <algorithm>  // min
+#include <cstddef>    // size_t
+
+namespace bf
+{
+  //
+  // More chunks than workers helps balance out uneven chunks.
+  //
+  static constexpr std::size_t k_ParallelChunksPerWorker = 4;
+
+  //
+  // Number of chunks `num_items` should be split into so that
+  // each chunk has at least `min_grain` items in it.
+  //
+  inline std::size_t parallelChunkCount(std::size_t num_items, std::size_t min_grain)
+  {
+    const std::size_t max_chunks = std::max(job::numWorkers(), std::size_t(1)) * k_ParallelChunksPerWorker;
+    const std::size_t num_chunks = (num_items + min_grain - 1) / std::max(min_grain, std::size_t(1));
+
+    return std::min(num_chunks, max_chunks);
+  }
+
+  //
+  // Calls `fn(chunk_index, idx_bgn, idx_end)` for each of the `num_chunks`
+  // even slices of [0, num_items) and blocks until all of them have finished.
+  //
+  // The calling thread helps execute the chunks while waiting.
+  //
+  template<typename F>
+  void parallelForChunks(std::size_t num_items, std::size_t num_chunks, F&& fn)
+  {
+    if (!num_items || !num_chunks)
+    {
+      return;
+    }
+
+    if (num_chunks == 1)
+    {
+      fn(std::size_t(0), std::size_t(0), num_items);
+      return;
+    }
+
+    job::Task* const root_task = job::taskMake([](job::Task*) {}, nullptr);
+
+    for (std::size_t chunk_index = 0; chunk_index < num_chunks; ++chunk_index)
+    {
+      const std::size_t idx_bgn = (num_items * chunk_index) / num_chunks;
+      const std::size_t idx_end = (num_items * (chunk_index + 1)) / num_chunks;
+
+      job::taskSubmit(
+       job::taskMake(
+        [fn_ptr = &fn, chunk_index, idx_bgn, idx_end](job::Task*) {
+          (*fn_ptr)(chunk_index, idx_bgn, idx_end);
+        },
+        root_task),
+       job::QueueType::HIGH);
+    }
+
+    job::taskSubmit(root_task, job::QueueType::HIGH);
+    job::waitOnTask(root_task);
+  }
+
+  //
+  // Calls `fn(item)` for each of the `num_items` items starting at `items_bgn`,
+  // split into jobs of at least `min_grain` items, and blocks until all are done.
+  //
+  // `It` only needs `it + offset`, so both pointers and the
+  // iterators of `Array<T>` and `DenseMap<T>` can be used.
+  //
+  template<typename It, typename F>
+  void parallelForEach(It items_bgn, std::size_t num_items, F&& fn, std::size_t min_grain)
+  {
+    parallelForChunks(
+     num_items,
+     parallelChunkCount(num_items, min_grain),
+     [&items_bgn, &fn](std::size_t, std::size_t idx_bgn, std::size_t idx_end) {
+       for (std::size_t i = idx_bgn; i < idx_end; ++i)
+       {
+         fn(*(items_bgn + i));
+       }
+     });
+  }
+
+  //
+  // Calls `fn(item)` for each item in a contiguous container (`Array<T>`, `DenseMap<T>`, ...).
+  //
+  template<typename Container, typename F>
+  void parallelForEach(Container& items, F&& fn, std::size_t min_grain)
+  {
+    parallelForEach(items.begin(), items.size(), fn, min_grain);
+  }
+}  // namespace bf
+
+#endif /* BF_PARALLEL_FOR_HPP */
@@ -4,6 +4,7 @@
 #include "bf/asset_io/bifrost_assets.hpp"
 #include "bf/asset_io/bifrost_scene.hpp"
 #include "bf/bf_dbg_logger.h"  // bfLog*
+#include "bf/ecs/bf_entity_storage.hpp"
 #include "bf/ecs/bifrost_behavior_system.hpp"
 #include "bf/ecs/bifrost_iecs_system.hpp"
 #include "bf/gfx/bf_render_queue.hpp"
@@ -44,6 +45,15 @@ namespace bf
   class BehaviorSystem;
   struct CommandBuffer2D;
 
+  // NOTE(SR):
+  //   Merged draws rely on Vulkan's `gl_InstanceIndex` including `firstInstance`,
+  //   the OpenGL backend has no base instance support so it draws them unmerged.
+#if BF_GFX_VULKAN
+  static constexpr std::uint8_t k_OpaqueQueueMergeInstances = RenderQueue::MERGE_INSTANCES;
+#else
+  static constexpr std::uint8_t k_OpaqueQueueMergeInstances = 0x0;
+#endif
+
   struct CameraRenderCreateParams
   {
     int width;
@@ -68,12 +78,13 @@ namespace bf
     RenderQueue       transparent_render_queue;
     RenderQueue       overlay_scene_render_queue;
     RenderQueue       screen_overlay_render_queue;
+    BVHCullingState   bvh_culling;
     RenderView*       prev;
     RenderView*       next;
     RenderView*       resize_list_next;
     std::uint8_t      flags;
 
-    RenderView(RenderView*& head, bfGfxDeviceHandle device, bfGfxFrameInfo frame_info, const CameraRenderCreateParams& params) :
+    RenderView(RenderView*& head, bfGfxDeviceHandle device, bfGfxFrameInfo frame_info, RenderCommandPagePool& command_memory, const CameraRenderCreateParams& params) :
       device{device},
       cpu_camera{},
       gpu_camera{},
@@ -81,10 +92,11 @@ namespace bf
       old_height{params.height},
       new_width{params.width},
       new_height{params.height},
-      opaque_render_queue{RenderQueue::SORT_COMMANDS | RenderQueue::SORT_DEPTH_FTB},
-      transparent_render_queue{RenderQueue::SORT_COMMANDS},
-      overlay_scene_render_queue{RenderQueue::SORT_COMMANDS | RenderQueue::SORT_DEPTH_FTB},
-      screen_overlay_render_queue{},
+      opaque_render_queue{command_memory, RenderQueue::SORT_COMMANDS | RenderQueue::SORT_DEPTH_FTB | RenderQueue::SORT_RADIX_BYTES | k_OpaqueQueueMergeInstances},
+      transparent_render_queue{command_memory, RenderQueue::SORT_COMMANDS | RenderQueue::SORT_RADIX_BYTES},
+      overlay_scene_render_queue{command_memory, RenderQueue::SORT_COMMANDS | RenderQueue::SORT_DEPTH_FTB | RenderQueue::SORT_RADIX_BYTES},
+      screen_overlay_render_queue{command_memory},
+      bvh_culling{command_memory.memory},
       prev{nullptr},
       next{head},
       resize_list_next{nullptr},
@@ -184,6 +196,7 @@ namespace bf
 
     MainHeap        m_MainMemory;
     LinearAllocator m_TempMemory;
+    EntityStorage   m_EntityStorage;
 
     // Core Low Level Systems
 
@@ -199,6 +212,7 @@ namespace bf
     DebugRenderer                         m_DebugRenderer;
     CommandBuffer2D*                      m_Gfx2D;
     CommandBuffer2D*                      m_2DScreenCommands;
+    RenderCommandPagePool                 m_RenderCommandMemory;
     RenderQueue                           m_2DScreenRenderQueue;
     MultiBuffer<CameraOverlayUniformData> m_2DScreenUBO;
     CameraRenderMemory                    m_CameraMemory;
@@ -222,8 +236,9 @@ namespace bf
 
     // Misc
 
-    EngineState m_State;
-    bool        m_IsInMiddleOfFrame;
+    EngineState      m_State;
+    bool             m_IsInMiddleOfFrame;
+    gc::CollectStats m_EntityGCStats;  //!< From the last collect at the end of a frame.
 
    public:
     explicit Engine(char* main_memory, std::size_t main_memory_size, int argc = 0, char* argv[] = nullptr);
@@ -232,6 +247,7 @@ namespace bf
 
     MainHeap&          mainMemory() { return m_MainMemory; }
     LinearAllocator&   tempMemory() { return m_TempMemory; }
+    EntityStorage&     entityStorage() { return m_EntityStorage; }
     GameStateMachine&  stateMachine() { return m_StateMachine; }
     VM&                scripting() { return m_Scripting; }
     StandardRenderer&  renderer() { return m_Renderer; }
@@ -250,7 +266,8 @@ namespace bf
 
     // Read-Only Accessors
 
-    float fixedDt() const { return float(std::chrono::duration_cast<std::chrono::milliseconds>(m_TimeStep).count()) / 1000.0f; }
+    float                   fixedDt() const { return float(std::chrono::duration_cast<std::chrono::milliseconds>(m_TimeStep).count()) / 1000.0f; }
+    const gc::CollectStats& entityGCStats() const { return m_EntityGCStats; }
 
     // Low Level Camera API
 
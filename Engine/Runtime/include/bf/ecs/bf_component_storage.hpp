@@ -5,33 +5,745 @@
  *   Contains the type that should be used to store
  *   engine components in a cache friendly manner.
  *
- * @version 0.0.1
+ *   Entities with the same set of components share an Archetype and
+ *   their components are packed together in fixed size chunks, one
+ *   array per component type, so systems that need more than one
+ *   component of an entity read them linearly rather than through
+ *   a lookup per component.
+ *
+ * @version 0.0.2
  * @date    2019-12-22
  *
- * @copyright Copyright (c) 2019-2020
+ * @copyright Copyright (c) 2019-2021
  */
 #ifndef BIFROST_COMPONENT_STORAGE_HPP
 #define BIFROST_COMPONENT_STORAGE_HPP
 
-#include "bf/data_structures/bifrost_container_tuple.hpp" /* ContainerTuple<T> */
-#include "bf/data_structures/bifrost_dense_map.hpp"       /* DenseMap<T>       */
-#include "bifrost_component_list.hpp"                     /* ComponentPack     */
+#include "bf/IMemoryManager.hpp"                          /* IMemoryManager         */
+#include "bf/bf_non_copy_move.hpp"                        /* NonCopyMoveable<T>     */
+#include "bf/core/bf_parallel_for.hpp"                    /* parallelForChunks      */
+#include "bf/data_structures/bifrost_array.hpp"           /* Array<T>               */
+#include "bf/data_structures/bifrost_container_tuple.hpp" /* for_each_template      */
+#include "bifrost_component_list.hpp"                     /* ComponentPack          */
+
+#include <algorithm>   /* min, max       */
+#include <cstdint>     /* uint32_t       */
+#include <new>         /* placement new  */
+#include <tuple>       /* tuple, apply   */
+#include <type_traits> /* remove_const_t */
 
 //
 // @EngineComponentRegister
-// The Array datatype needs to know the sizeof(T) in it's constructor. (This requirement should be removed in later versions of this engine.)
+// The storage needs the complete type of every component to lay out the chunks.
 //
 #include "bf/ecs/bifrost_light.hpp"              /* Light        */
 #include "bf/ecs/bifrost_renderer_component.hpp" /* MeshRenderer */
 
 namespace bf
 {
+  class Archetype;
+  class ComponentStorage;
+  struct ArchetypeChunk;
+
+  //
+  // Bit `i` is set when the component at index `i` of the `ComponentPack` is present.
+  //
+  using ComponentMask = std::uint32_t;
+
+  static constexpr std::size_t k_NumComponentTypes = ComponentPack::size;
+  static constexpr std::size_t k_ArchetypeChunkSize = 16u * 1024u;  //!< Target size in bytes of a single chunk, a chunk only grows past this if one row does not fit.
+
+  static_assert(k_NumComponentTypes <= sizeof(ComponentMask) * 8u, "ComponentMask is too small to hold a bit per component type.");
+
+  namespace detail
+  {
+    template<typename... Ts>
+    struct ComponentPackInfoImpl
+    {
+      template<typename F>
+      static void forEachType(F&& f)
+      {
+        meta::for_each_template<Ts...>(std::forward<F>(f));
+      }
+
+      template<typename T>
+      static constexpr std::size_t indexOf()
+      {
+        return get_index_of_element_from_tuple_by_type_impl<std::remove_const_t<T>, 0, Ts...>::value;
+      }
+    };
+
+    using ComponentPackInfo = ComponentPack::apply<ComponentPackInfoImpl>;
+  }  // namespace detail
+
+  template<typename T>
+  static constexpr std::size_t k_ComponentIndex = detail::ComponentPackInfo::indexOf<T>();
+
+  template<typename T>
+  static constexpr ComponentMask k_ComponentMask = ComponentMask(1u) << k_ComponentIndex<T>;
+
+  template<typename... Ts>
+  static constexpr ComponentMask k_ComponentsMask = (ComponentMask(0u) | ... | k_ComponentMask<Ts>);
+
+  //
+  // Where an Entity's components live inside of a `ComponentStorage`,
+  // owned by the Entity and kept up to date by the storage as rows move around.
+  //
+  struct ComponentRow final
+  {
+    ArchetypeChunk* chunk = nullptr;  //!< nullptr when the Entity has no components in this storage.
+    std::uint32_t   index = 0u;
+  };
+
+  /*!
+   * @brief
+   *   A block of memory holding up to `Archetype::chunkCapacity` rows
+   *   with one tightly packed array per component type.
+   *
+   *   Rows are always packed to the front of the chunk.
+   *
+   *   Each row has a mask of which of its components are enabled, views and
+   *   queries skip over disabled components so turning one on or off is
+   *   a bit flip rather than moving the component to another storage.
+   */
+  struct ArchetypeChunk final
+  {
+    Archetype*     archetype;         //!< The archetype that owns this chunk.
+    ComponentRow** rows;              //!< The owner of each row, so it can be patched up when the row moves.
+    ComponentMask* enabled;           //!< The enabled components of each row.
+    std::uint32_t  num_rows;          //!< Number of rows in use.
+    std::uint32_t  num_partial_rows;  //!< Number of rows with at least one disabled component, while zero `enabled` does not need to be checked.
+
+    [[nodiscard]] std::uint32_t size() const { return num_rows; }
+    [[nodiscard]] bool          has(ComponentMask mask) const;
+    [[nodiscard]] bool          isEnabled(std::uint32_t row, ComponentMask mask) const { return !num_partial_rows || (enabled[row] & mask) == mask; }
+    [[nodiscard]] std::uint32_t numEnabled(ComponentMask mask) const;
+    void                        setEnabled(std::uint32_t row, ComponentMask mask, bool value);
+
+    template<typename T>
+    [[nodiscard]] T* components() const
+    {
+      return static_cast<T*>(column(k_ComponentIndex<T>));
+    }
+
+    [[nodiscard]] void* column(std::size_t type_index) const;
+  };
+
+  /*!
+   * @brief
+   *   All of the chunks for a single set of component types.
+   */
+  class Archetype final : private NonCopyMoveable<Archetype>
+  {
+    friend class ComponentStorage;
+
+   private:
+    IMemoryManager&        m_Memory;
+    ComponentMask          m_Mask;                                //!< The component types each row has.
+    std::uint32_t          m_ChunkCapacity;                       //!< Max number of rows in a chunk.
+    std::size_t            m_ChunkSize;                           //!< Number of bytes a chunk takes up.
+    std::uint32_t          m_ColumnOffsets[k_NumComponentTypes];  //!< Byte offset from the start of a chunk, 0 for types not in this archetype.
+    Array<ArchetypeChunk*> m_Chunks;                              //!< Every chunk is full except for the last one.
+    std::size_t            m_NumRows;                             //!<
+
+   public:
+    Archetype(IMemoryManager& memory, ComponentMask mask);
+
+    [[nodiscard]] ComponentMask                 mask() const { return m_Mask; }
+    [[nodiscard]] bool                          has(ComponentMask mask) const { return (m_Mask & mask) == mask; }
+    [[nodiscard]] std::uint32_t                 chunkCapacity() const { return m_ChunkCapacity; }
+    [[nodiscard]] std::size_t                   numRows() const { return m_NumRows; }
+    [[nodiscard]] const Array<ArchetypeChunk*>& chunks() const { return m_Chunks; }
+    [[nodiscard]] std::uint32_t                 columnOffset(std::size_t type_index) const { return m_ColumnOffsets[type_index]; }
+
+    ~Archetype();
+
+   private:
+    ComponentRow allocateRow(ComponentRow* owner, ComponentMask enabled);
+    void         freeRow(ArchetypeChunk* chunk, std::uint32_t index);
+  };
+
+  inline bool ArchetypeChunk::has(ComponentMask mask) const
+  {
+    return archetype->has(mask);
+  }
+
+  inline void* ArchetypeChunk::column(std::size_t type_index) const
+  {
+    return const_cast<char*>(reinterpret_cast<const char*>(this)) + archetype->columnOffset(type_index);
+  }
+
+  inline std::uint32_t ArchetypeChunk::numEnabled(ComponentMask mask) const
+  {
+    if (!num_partial_rows)
+    {
+      return num_rows;
+    }
+
+    std::uint32_t result = 0u;
+
+    for (std::uint32_t i = 0u; i < num_rows; ++i)
+    {
+      result += (enabled[i] & mask) == mask;
+    }
+
+    return result;
+  }
+
+  inline void ArchetypeChunk::setEnabled(std::uint32_t row, ComponentMask mask, bool value)
+  {
+    const ComponentMask all_mask    = archetype->mask();
+    const bool          was_partial = enabled[row] != all_mask;
+
+    enabled[row] = value ? (enabled[row] | (mask & all_mask)) : (enabled[row] & ~mask);
+
+    num_partial_rows += std::uint32_t(enabled[row] != all_mask) - std::uint32_t(was_partial);
+  }
+
+  using ArchetypeIt = Archetype* const*;
+
+  /*!
+   * @brief
+   *   Steps through each non empty chunk of the archetypes that
+   *   have at least the components in a mask.
+   *
+   *   Matching is done once per archetype with a bit test so there
+   *   is no per entity filtering.
+   */
+  class ArchetypeChunkCursor
+  {
+   private:
+    ArchetypeIt   m_Archetype;
+    ArchetypeIt   m_ArchetypeEnd;
+    ComponentMask m_Mask;
+    std::size_t   m_ChunkIndex;
+
+   public:
+    ArchetypeChunkCursor(ArchetypeIt archetype, ArchetypeIt archetype_end, ComponentMask mask) :
+      m_Archetype{archetype},
+      m_ArchetypeEnd{archetype_end},
+      m_Mask{mask},
+      m_ChunkIndex{0u}
+    {
+      skipEmptyArchetypes();
+    }
+
+    // nullptr once every chunk has been visited.
+    [[nodiscard]] ArchetypeChunk* chunk() const
+    {
+      return m_Archetype != m_ArchetypeEnd ? (*m_Archetype)->chunks()[m_ChunkIndex] : nullptr;
+    }
+
+    void next()
+    {
+      if (++m_ChunkIndex == (*m_Archetype)->chunks().size())
+      {
+        m_ChunkIndex = 0u;
+        ++m_Archetype;
+        skipEmptyArchetypes();
+      }
+    }
+
+    bool operator==(const ArchetypeChunkCursor& rhs) const { return m_Archetype == rhs.m_Archetype && m_ChunkIndex == rhs.m_ChunkIndex; }
+    bool operator!=(const ArchetypeChunkCursor& rhs) const { return !(*this == rhs); }
+
+   private:
+    void skipEmptyArchetypes()
+    {
+      while (m_Archetype != m_ArchetypeEnd && !((*m_Archetype)->numRows() && (*m_Archetype)->has(m_Mask)))
+      {
+        ++m_Archetype;
+      }
+    }
+  };
+
+  /*!
+   * @brief
+   *   Steps through each row that has all of the components
+   *   in a mask enabled, one chunk after another.
+   */
+  class ArchetypeRowCursor
+  {
+   private:
+    ArchetypeChunkCursor m_Cursor;
+    ComponentMask        m_Mask;
+    std::uint32_t        m_RowIndex;
+
+   public:
+    ArchetypeRowCursor(ArchetypeIt archetype, ArchetypeIt archetype_end, ComponentMask mask) :
+      m_Cursor{archetype, archetype_end, mask},
+      m_Mask{mask},
+      m_RowIndex{0u}
+    {
+      skipDisabledRows();
+    }
+
+    // nullptr once every row has been visited.
+    [[nodiscard]] ArchetypeChunk* chunk() const { return m_Cursor.chunk(); }
+    [[nodiscard]] std::uint32_t   row() const { return m_RowIndex; }
+
+    void next()
+    {
+      ++m_RowIndex;
+      skipDisabledRows();
+    }
+
+    bool operator==(const ArchetypeRowCursor& rhs) const { return m_Cursor == rhs.m_Cursor && m_RowIndex == rhs.m_RowIndex; }
+    bool operator!=(const ArchetypeRowCursor& rhs) const { return !(*this == rhs); }
+
+   private:
+    void skipDisabledRows()
+    {
+      while (ArchetypeChunk* const chunk = m_Cursor.chunk())
+      {
+        while (m_RowIndex < chunk->num_rows)
+        {
+          if (chunk->isEnabled(m_RowIndex, m_Mask))
+          {
+            return;
+          }
+
+          ++m_RowIndex;
+        }
+
+        m_RowIndex = 0u;
+        m_Cursor.next();
+      }
+    }
+  };
+
+  namespace detail
+  {
+    inline std::size_t countRows(ArchetypeIt archetype_bgn, ArchetypeIt archetype_end, ComponentMask mask)
+    {
+      std::size_t result = 0u;
+
+      for (ArchetypeChunkCursor cursor = {archetype_bgn, archetype_end, mask}; cursor.chunk(); cursor.next())
+      {
+        result += cursor.chunk()->numEnabled(mask);
+      }
+
+      return result;
+    }
+  }  // namespace detail
+
+  /*!
+   * @brief
+   *   Iterates over every enabled `T` in a storage, one chunk after another.
+   */
   template<typename T>
-  using ComponentHandleImpl = DenseMapHandle<T, 12u, 20u>;
+  class ComponentView
+  {
+   public:
+    class iterator
+    {
+     public:
+      using self_type  = iterator;
+      using value_type = T;
+      using reference  = value_type&;
+      using pointer    = value_type*;
+
+     private:
+      ArchetypeRowCursor    m_Cursor;
+      const ArchetypeChunk* m_Chunk;       //!< The chunk `m_Components` was loaded from.
+      T*                    m_Components;  //!< The `T` column of the current chunk.
+
+     public:
+      iterator(ArchetypeIt archetype, ArchetypeIt archetype_end) :
+        m_Cursor{archetype, archetype_end, k_ComponentMask<T>},
+        m_Chunk{nullptr},
+        m_Components{nullptr}
+      {
+        loadChunk();
+      }
+
+      self_type& operator++()  // Pre-fix
+      {
+        m_Cursor.next();
+
+        if (m_Cursor.chunk() != m_Chunk)
+        {
+          loadChunk();
+        }
+
+        return *this;
+      }
+
+      self_type operator++(int)  // Post-fix
+      {
+        self_type it = (*this);
+        ++(*this);
+
+        return it;
+      }
+
+      bool      operator==(const iterator& rhs) const { return m_Cursor == rhs.m_Cursor; }
+      bool      operator!=(const iterator& rhs) const { return !(*this == rhs); }
+      reference operator*() const { return m_Components[m_Cursor.row()]; }
+      pointer   operator->() const { return m_Components + m_Cursor.row(); }
+
+     private:
+      void loadChunk()
+      {
+        m_Chunk      = m_Cursor.chunk();
+        m_Components = m_Chunk ? m_Chunk->components<T>() : nullptr;
+      }
+    };
+
+   private:
+    ArchetypeIt m_ArchetypeBgn;
+    ArchetypeIt m_ArchetypeEnd;
+
+   public:
+    ComponentView(ArchetypeIt archetype_bgn, ArchetypeIt archetype_end) :
+      m_ArchetypeBgn{archetype_bgn},
+      m_ArchetypeEnd{archetype_end}
+    {
+    }
+
+    [[nodiscard]] iterator    begin() const { return iterator(m_ArchetypeBgn, m_ArchetypeEnd); }
+    [[nodiscard]] iterator    end() const { return iterator(m_ArchetypeEnd, m_ArchetypeEnd); }
+    [[nodiscard]] bool        isEmpty() const { return begin() == end(); }
+    [[nodiscard]] std::size_t size() const { return detail::countRows(m_ArchetypeBgn, m_ArchetypeEnd, k_ComponentMask<T>); }
+  };
+
+  /*!
+   * @brief
+   *   Iterates over every entity that has all of `Ts`, yielding a
+   *   reference to each of the components.
+   *
+   *   Usage:
+   *     for (auto [mesh, light] : scene.query<MeshRenderer, Light>()) { ... }
+   *
+   *     scene.query<MeshRenderer, Light>().forEach([](MeshRenderer& mesh, Light& light) { ... });
+   *
+   *   `forEach` is the faster of the two since the inner loop
+   *   is a plain loop over the arrays of a single chunk.
+   */
+  template<typename... Ts>
+  class ComponentQuery
+  {
+    static_assert(sizeof...(Ts) > 0u, "A query needs at least one component type.");
+
+   public:
+    using Columns   = std::tuple<Ts*...>;
+    using reference = std::tuple<Ts&...>;
+
+    static constexpr ComponentMask k_Mask = k_ComponentsMask<Ts...>;
+
+    class iterator
+    {
+     public:
+      using self_type  = iterator;
+      using value_type = reference;
+
+     private:
+      ArchetypeRowCursor    m_Cursor;
+      const ArchetypeChunk* m_Chunk;    //!< The chunk `m_Columns` was loaded from.
+      Columns               m_Columns;  //!< The columns of the current chunk.
+
+     public:
+      iterator(ArchetypeIt archetype, ArchetypeIt archetype_end) :
+        m_Cursor{archetype, archetype_end, k_Mask},
+        m_Chunk{nullptr},
+        m_Columns{}
+      {
+        loadChunk();
+      }
+
+      self_type& operator++()  // Pre-fix
+      {
+        m_Cursor.next();
+
+        if (m_Cursor.chunk() != m_Chunk)
+        {
+          loadChunk();
+        }
+
+        return *this;
+      }
+
+      self_type operator++(int)  // Post-fix
+      {
+        self_type it = (*this);
+        ++(*this);
+
+        return it;
+      }
+
+      bool operator==(const iterator& rhs) const { return m_Cursor == rhs.m_Cursor; }
+      bool operator!=(const iterator& rhs) const { return !(*this == rhs); }
+
+      reference operator*() const
+      {
+        return std::apply([row = m_Cursor.row()](Ts*... columns) { return reference{columns[row]...}; }, m_Columns);
+      }
+
+     private:
+      void loadChunk()
+      {
+        m_Chunk = m_Cursor.chunk();
+
+        if (m_Chunk)
+        {
+          m_Columns = Columns{m_Chunk->components<Ts>()...};
+        }
+      }
+    };
+
+   private:
+    ArchetypeIt m_ArchetypeBgn;
+    ArchetypeIt m_ArchetypeEnd;
+
+   public:
+    ComponentQuery(ArchetypeIt archetype_bgn, ArchetypeIt archetype_end) :
+      m_ArchetypeBgn{archetype_bgn},
+      m_ArchetypeEnd{archetype_end}
+    {
+    }
+
+    [[nodiscard]] iterator    begin() const { return iterator(m_ArchetypeBgn, m_ArchetypeEnd); }
+    [[nodiscard]] iterator    end() const { return iterator(m_ArchetypeEnd, m_ArchetypeEnd); }
+    [[nodiscard]] bool        isEmpty() const { return begin() == end(); }
+    [[nodiscard]] std::size_t size() const { return detail::countRows(m_ArchetypeBgn, m_ArchetypeEnd, k_Mask); }
+
+    //
+    // Calls `fn(Ts&...)` for each matching entity.
+    //
+    template<typename F>
+    void forEach(F&& fn) const
+    {
+      forEachChunk([&fn](ArchetypeChunk& chunk) {
+        forEachInChunk(chunk, fn);
+      });
+    }
+
+    //
+    // Calls `fn(ArchetypeChunk&)` for each chunk with all of `Ts`.
+    //
+    template<typename F>
+    void forEachChunk(F&& fn) const
+    {
+      for (ArchetypeChunkCursor cursor = {m_ArchetypeBgn, m_ArchetypeEnd, k_Mask}; cursor.chunk(); cursor.next())
+      {
+        fn(*cursor.chunk());
+      }
+    }
+
+    //
+    // Calls `fn(Ts&...)` for the matching entities whose position
+    // in iteration order is within [idx_bgn, idx_end).
+    //
+    template<typename F>
+    void forEachInRange(std::size_t idx_bgn, std::size_t idx_end, F&& fn) const
+    {
+      std::size_t chunk_bgn = 0u;
+
+      for (ArchetypeChunkCursor cursor = {m_ArchetypeBgn, m_ArchetypeEnd, k_Mask}; cursor.chunk() && chunk_bgn < idx_end; cursor.next())
+      {
+        ArchetypeChunk&   chunk     = *cursor.chunk();
+        const std::size_t chunk_end = chunk_bgn + chunk.numEnabled(k_Mask);
+
+        if (chunk_end > idx_bgn)
+        {
+          forEachInChunkImpl(
+           chunk,
+           fn,
+           std::uint32_t(std::max(idx_bgn, chunk_bgn) - chunk_bgn),
+           std::uint32_t(std::min(idx_end, chunk_end) - chunk_bgn),
+           chunk.components<Ts>()...);
+        }
+
+        chunk_bgn = chunk_end;
+      }
+    }
+
+    //
+    // Calls `fn(Ts&...)` for each matching entity from jobs of at least
+    // `min_grain` entities and blocks until all of them have finished.
+    //
+    // No components may be added or removed until this returns.
+    //
+    template<typename F>
+    void parallelForEach(F&& fn, std::size_t min_grain) const
+    {
+      const std::size_t num_items = size();
+
+      parallelForChunks(
+       num_items,
+       parallelChunkCount(num_items, min_grain),
+       [this, &fn](std::size_t, std::size_t idx_bgn, std::size_t idx_end) {
+         forEachInRange(idx_bgn, idx_end, fn);
+       });
+    }
+
+    //
+    // Calls `fn(Ts&...)` for each enabled row of a chunk from this query.
+    //
+    template<typename F>
+    static void forEachInChunk(ArchetypeChunk& chunk, F&& fn)
+    {
+      forEachInChunkImpl(chunk, fn, 0u, chunk.size(), chunk.components<Ts>()...);
+    }
+
+   private:
+    // `enabled_bgn` and `enabled_end` count only the enabled rows of the chunk.
+    template<typename F>
+    static void forEachInChunkImpl(const ArchetypeChunk& chunk, F& fn, std::uint32_t enabled_bgn, std::uint32_t enabled_end, Ts*... columns)
+    {
+      if (!chunk.num_partial_rows)
+      {
+        for (std::uint32_t i = enabled_bgn; i < enabled_end; ++i)
+        {
+          fn(columns[i]...);
+        }
+      }
+      else
+      {
+        std::uint32_t enabled_index = 0u;
+
+        for (std::uint32_t i = 0u; i < chunk.num_rows && enabled_index < enabled_end; ++i)
+        {
+          if (chunk.isEnabled(i, k_Mask))
+          {
+            if (enabled_index >= enabled_bgn)
+            {
+              fn(columns[i]...);
+            }
+
+            ++enabled_index;
+          }
+        }
+      }
+    }
+  };
+
+  /*!
+   * @brief
+   *   Owns the components of a set of entities grouped by Archetype.
+   *
+   *   Adding or removing a component moves the rest of that Entity's components
+   *   to a new Archetype so pointers to components are only stable until the
+   *   next structural change of that same Entity.
+   *
+   *   Enabling or disabling a component does not move anything,
+   *   it only changes whether views and queries will see it.
+   */
+  class ComponentStorage final : private NonCopyMoveable<ComponentStorage>
+  {
+   private:
+    IMemoryManager&   m_Memory;
+    Array<Archetype*> m_Archetypes;
+
+   public:
+    template<typename F>
+    static void forEachType(F&& f)
+    {
+      detail::ComponentPackInfo::forEachType(std::forward<F>(f));
+    }
+
+   public:
+    explicit ComponentStorage(IMemoryManager& memory);
+
+    // Component API
+
+    template<typename T, typename... Args>
+    T* add(ComponentRow& row, Args&&... args)
+    {
+      return new (addColumn(row, k_ComponentIndex<T>)) T(std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    [[nodiscard]] T* find(const ComponentRow& row) const
+    {
+      return row.chunk && row.chunk->has(k_ComponentMask<T>) ? row.chunk->components<T>() + row.index : nullptr;
+    }
+
+    template<typename T>
+    void remove(ComponentRow& row)
+    {
+      removeColumn(row, k_ComponentIndex<T>);
+    }
+
+    //
+    // Components start out enabled when added.
+    //
+    template<typename T>
+    [[nodiscard]] bool isEnabled(const ComponentRow& row) const
+    {
+      return row.chunk->isEnabled(row.index, k_ComponentMask<T>);
+    }
+
+    template<typename T>
+    void setEnabled(const ComponentRow& row, bool value)
+    {
+      row.chunk->setEnabled(row.index, k_ComponentMask<T>, value);
+    }
+
+    //
+    // Destroys every component of the row at once rather than moving
+    // what is left of the row to a new Archetype for each one.
+    //
+    void removeAll(ComponentRow& row)
+    {
+      if (row.chunk)
+      {
+        moveRow(row, 0u);
+      }
+    }
+
+    // Query API
+
+    template<typename T>
+    [[nodiscard]] ComponentView<T> view() const
+    {
+      return {m_Archetypes.begin(), m_Archetypes.end()};
+    }
+
+    template<typename... Ts>
+    [[nodiscard]] ComponentQuery<Ts...> query() const
+    {
+      return {m_Archetypes.begin(), m_Archetypes.end()};
+    }
+
+    //
+    // Calls `fn(ArchetypeChunk&)` for each chunk with at least the components in `mask`.
+    // The chunks may have disabled rows, check `ArchetypeChunk::isEnabled` for each row.
+    //
+    template<typename F>
+    void forEachChunk(ComponentMask mask, F&& fn) const
+    {
+      for (Archetype* const archetype : m_Archetypes)
+      {
+        if (archetype->has(mask))
+        {
+          for (ArchetypeChunk* const chunk : archetype->chunks())
+          {
+            fn(*chunk);
+          }
+        }
+      }
+    }
+
+    //
+    // Writes out each chunk with at least the components in `mask`.
+    // Pass nullptr for `out_chunks` to get the number of chunks to allocate for.
+    //
+    // The chunks may have disabled rows, check `ArchetypeChunk::isEnabled` for each row.
+    //
+    std::size_t findChunks(ComponentMask mask, ArchetypeChunk** out_chunks) const;
+
+    // Number of rows with all of the components in `mask` enabled.
+    [[nodiscard]] std::size_t count(ComponentMask mask) const;
+
+    ~ComponentStorage();
 
-  template<typename... Args>
-  using DenseMapTuple    = ContainerTuple<DenseMap, ComponentHandleImpl<Args>...>;
-  using ComponentStorage = ComponentPack::apply<DenseMapTuple>;
+   private:
+    void*      addColumn(ComponentRow& row, std::size_t type_index);
+    void       removeColumn(ComponentRow& row, std::size_t type_index);
+    void       moveRow(ComponentRow& row, ComponentMask new_mask);
+    Archetype* findOrCreateArchetype(ComponentMask mask);
+  };
 }  // namespace bf
 
 #endif /* BIFROST_COMPONENT_STORAGE_HPP */
@@ -20,7 +20,7 @@
 #include "bf/math/bifrost_transform.h"           // bfTransform
 #include "bf_component_storage.hpp"              // ComponentStorage
 #include "bifrost_collision_system.hpp"          // BVHNodeOffset
-#include "bifrost_component_handle_storage.hpp"  // ComponentHandleStorage, ComponentActiveStorage
+#include "bifrost_component_handle_storage.hpp"  // ComponentActiveStorage
 
 #include <atomic>  // std::atomic_uint32_t
 
@@ -92,11 +92,12 @@ namespace bf
     ListNode<Entity>       m_Hierarchy;              //!<
     ListNode<Entity>       m_GCList;                 //!<
     BehaviorList           m_Behaviors;              //!<
-    ComponentHandleStorage m_ComponentHandles;       //!<
+    ComponentRow           m_ComponentRow;           //!< Where this entity's components are in the scene's storage.
     bfTransform            m_Transform;              //!<
     std::atomic_uint32_t   m_RefCount;               //!<
     ComponentActiveStorage m_ComponentActiveStates;  //!<
     std::uint8_t           m_Flags;                  //!<
+    std::uint32_t          m_GCGeneration;           //!< The last `gc::collect` that found this Entity still referenced.
     bfUUIDNumber           m_UUID;                   //!< This uuid will remain unset until the first use through "Entity::uuid".
 
    public:
@@ -142,19 +143,23 @@ namespace bf
     {
       if (!has<T>())
       {
-        const bool is_active = isActive();
-        auto&      handle    = componentHandle<T>();
+        const bool        is_active = isActive();
+        ComponentStorage& storage   = sceneComponentStorage();
+        Engine&           engine    = this->engine();
 
-        handle.handle = getComponentList<T>(is_active).add(*this);
+        storage.add<T>(m_ComponentRow, *this);
+        storage.setEnabled<T>(m_ComponentRow, is_active);
         setComponentActiveState<T>(is_active);
-        Engine&  engine    = this->engine();
-        T* const component = get<T>();
 
-        ComponentTraits::onCreate(*component, engine);
+        // NOTE(SR):
+        //   Each hook looks the component up again since `onCreate` is allowed
+        //   to add or remove components which moves this entity's row.
+
+        ComponentTraits::onCreate(*get<T>(), engine);
 
         if (is_active)
         {
-          ComponentTraits::onEnable(*component, engine);
+          ComponentTraits::onEnable(*get<T>(), engine);
         }
       }
 
@@ -164,19 +169,19 @@ namespace bf
     template<typename T>
     T* get() const
     {
-      return getImpl<T>(isActive());
+      return sceneComponentStorage().find<T>(m_ComponentRow);
     }
 
     template<typename T>
     bool has() const
     {
-      return hasImpl<T>(isActive());
+      return get<T>() != nullptr;
     }
 
     template<typename T>
     bool isComponentActive() const
     {
-      return getComponentActiveState<T>() && componentHandle<T>().handle.isValid();
+      return getComponentActiveState<T>();
     }
 
     template<typename T>
@@ -190,19 +195,17 @@ namespace bf
     template<typename T>
     bool remove()
     {
-      auto& handle = m_ComponentHandles.get<T>();
+      T* const component = get<T>();
 
-      if (handle.handle.isValid())
+      if (component)
       {
-        Engine&  engine    = this->engine();
-        T* const component = get<T>();
+        Engine& engine = this->engine();
 
         // TODO(SR): This should not be called if the component was already inactive.
         ComponentTraits::onDisable(*component, engine);
         ComponentTraits::onDestroy(*component, engine);
 
-        getComponentList<T>(getComponentActiveState<T>()).remove(handle.handle);
-        handle.handle = {};
+        sceneComponentStorage().remove<T>(m_ComponentRow);
         setComponentActiveState<T>(false);
 
         return true;
@@ -286,59 +289,31 @@ namespace bf
       bfTransform_copyFrom(&transform(), &value);
     }
 
-    template<typename T>
-    T* getImpl(bool was_active) const
-    {
-      const auto& handle = componentHandle<T>();
-
-      if (handle.handle.isValid())
-      {
-        const bool active_list = was_active && getComponentActiveState<T>();
-
-        return &getComponentList<T>(active_list).find(handle.handle);
-      }
-
-      return nullptr;
-    }
-
-    template<typename T>
-    bool hasImpl(bool was_active) const
-    {
-      return getImpl<T>(was_active) != nullptr;
-    }
-
-    // Returns whether or not the component changed lists.
+    // Returns whether or not the component was enabled or disabled in the scene's storage.
+    // The component stays where it is, so pointers to it are still valid afterwards.
     template<typename T>
     bool setComponentActiveImpl(bool was_active, bool is_active, bool value)
     {
-      if (hasImpl<T>(was_active))
+      T* const component = get<T>();
+
+      if (component)
       {
-        const bool src_list     = was_active && isComponentActive<T>();
-        const bool dst_list     = is_active && value;
-        const bool needs_change = src_list != dst_list;
+        const bool was_enabled  = was_active && getComponentActiveState<T>();
+        const bool is_enabled   = is_active && value;
+        const bool needs_change = was_enabled != is_enabled;
 
         if (needs_change)
         {
-          auto& handle     = componentHandle<T>();
-          T&    old_data   = *getImpl<T>(was_active);
-          auto& new_list   = getComponentList<T>(dst_list);
-          auto  new_handle = new_list.add(*this);
-          T&    new_data   = new_list.find(new_handle);
+          sceneComponentStorage().setEnabled<T>(m_ComponentRow, is_enabled);
 
-          new_data = std::move(old_data);
-
-          if (value)
+          if (is_enabled)
           {
-            ComponentTraits::onEnable(new_data, engine());
+            ComponentTraits::onEnable(*component, engine());
           }
           else
           {
-            ComponentTraits::onDisable(new_data, engine());
+            ComponentTraits::onDisable(*component, engine());
           }
-
-          getComponentList<T>(src_list).remove(handle.handle);
-
-          handle.handle = new_handle;
         }
 
         setComponentActiveState<T>(value);
@@ -349,24 +324,6 @@ namespace bf
       return false;
     }
 
-    template<typename T>
-    DenseMap<ComponentHandleImpl<T>>& getComponentList(bool is_active) const
-    {
-      return sceneComponentStorage(is_active).get<ComponentHandleImpl<T>>();
-    }
-
-    template<typename T>
-    ComponentHandle<T>& componentHandle()
-    {
-      return m_ComponentHandles.get<T>();
-    }
-
-    template<typename T>
-    const ComponentHandle<T>& componentHandle() const
-    {
-      return m_ComponentHandles.get<T>();
-    }
-
     template<typename T>
     bool getComponentActiveState() const
     {
@@ -387,13 +344,13 @@ namespace bf
     bool        removeBehaviorFromList(meta::BaseClassMetaInfoPtr type);       // false if could not find behavior to be removed
     void        deleteBehavior(BaseBehavior* behavior) const;
 
-    ComponentStorage& sceneComponentStorage(bool is_active) const;
+    ComponentStorage& sceneComponentStorage() const;
     IMemoryManager&   sceneMemoryManager() const;
 
     void toggleFlags(std::uint8_t flags);
 
    private:
-    friend void gc::collect(IMemoryManager& entity_memory);
+    friend gc::CollectStats gc::collect(IMemoryManager& entity_memory, const gc::CollectBudget& budget);
   };
 }  // namespace bf
 
@@ -1,129 +1,78 @@
-// Feb 20th
+/******************************************************************************/
+/*!
+ * @file   bf_entity_storage.hpp
+ * @author Shareef Abdoul-Raheem (http://blufedora.github.io/)
+ * @brief
+ *   Pooled memory for Entities so that spawning and destroying a lot
+ *   of them does not go through the general purpose heap one at a time.
+ *
+ * @version 0.0.1
+ * @date    2021-02-20
+ *
+ * @copyright Copyright (c) 2021
+ */
+/******************************************************************************/
 #ifndef BF_ENTITY_STORAGE_HPP
 #define BF_ENTITY_STORAGE_HPP
 
-#include "bf/IMemoryManager.hpp"     // IMemoryManager
-#include "bf/ListView.hpp"           // List<T>
-#include "bf/PoolAllocator.hpp"      // PoolAllocator<T, num_elements>
-#include "bf_component_storage.hpp"  // ComponentStorage
-#include "bf_entity.hpp"             // Entity
+#include "bf/IMemoryManager.hpp"                  // IMemoryManager
+#include "bf/bf_non_copy_move.hpp"                // NonCopyMoveable<T>
+#include "bf/data_structures/bifrost_string.hpp"  // StringRange
 
-#include <array>
+#include <cstddef>  // size_t
 
 namespace bf
 {
-  static constexpr std::uint16_t k_MaxEntitiesPerChunk       = (1u << 16) - 1u;
-  static constexpr std::uint16_t k_MaxEntitiesPerChunkPiece  = (1u << 12);
-  static constexpr std::uint16_t k_NumEntityChunksPerStorage = (k_MaxEntitiesPerChunk + 1u) / k_MaxEntitiesPerChunkPiece;
-
+  class Entity;
   class Scene;
 
-  struct EntityChunkPiece
+  static constexpr std::size_t k_NumEntitiesPerChunk = 256u;
+
+  /*!
+   * @brief
+   *   Hands out Entity sized slots from chunks of `k_NumEntitiesPerChunk`.
+   *
+   *   Freed slots are kept in a free list and reused, chunks are
+   *   only returned to the backing allocator once the storage is destroyed.
+   *
+   *   This is an IMemoryManager so that the Entity GC can free
+   *   Entities through it without knowing where they came from.
+   */
+  class EntityStorage final : public IMemoryManager, private NonCopyMoveable<EntityStorage>
   {
-    using Allocator = PoolAllocator<Entity, k_MaxEntitiesPerChunk>;
-
-    Allocator     allocator;
-    std::uint16_t num_allocated_left;
-
-    EntityChunkPiece() :
-      allocator{},
-      num_allocated_left{k_MaxEntitiesPerChunk}
-    {
-    }
-
-    Entity* alloc(Scene& scene)
-    {
-      return allocator.allocateT<Entity>(scene);
-    }
-  };
-
-  using EntityChunkPieceArray = std::array<EntityChunkPiece*, k_NumEntityChunksPerStorage>;
-  using EntityIDToEntity      = HashTable<std::uint16_t, Entity*>;
+   private:
+    struct EntityChunk;
+    union EntitySlot;
 
-  class EntityChunk
-  {
    private:
-    IMemoryManager&       m_Memory;
-    BVH                   m_BVH;
-    ComponentStorage      m_ActiveComponents;
-    ComponentStorage      m_InactiveComponents;
-    EntityChunkPieceArray m_Pieces;
-    std::uint16_t         m_NumEntitiesLeft;
+    IMemoryManager& m_Memory;
+    EntityChunk*    m_Chunks;
+    EntitySlot*     m_FreeList;
+    std::size_t     m_NumFreeSlots;
 
    public:
-    EntityChunk(IMemoryManager& memory) :
-      m_Memory{memory},
-      m_BVH{memory},
-      m_ActiveComponents{memory},
-      m_InactiveComponents{memory},
-      m_Pieces{},
-      m_NumEntitiesLeft{k_MaxEntitiesPerChunk}
-    {
-      std::fill(m_Pieces.begin(), m_Pieces.end(), nullptr);
-    }
-
-    std::uint16_t allocateEntities(std::size_t num_entities, Scene& scene, Entity** results)
-    {
-      const std::uint16_t num_actual_alloc = std::min(m_NumEntitiesLeft, std::uint16_t(num_entities));
-      std::uint16_t       num_to_alloc     = num_actual_alloc;
-
-      while (num_to_alloc)
-      {
-        for (EntityChunkPiece*& piece : m_Pieces)
-        {
-          if (!piece)
-          {
-            piece = m_Memory.allocateT<EntityChunkPiece>();
-          }
+    explicit EntityStorage(IMemoryManager& memory);
 
-          const std::uint16_t num_to_alloc_in_piece = std::min(piece->num_allocated_left, num_to_alloc);
+    //
+    // Makes sure the next `num_entities` allocations will not need to allocate a new chunk.
+    //
+    void reserve(std::size_t num_entities);
 
-          num_to_alloc -= num_to_alloc_in_piece;
+    //
+    // Constructs `num_entities` Entities into `results`, all of them belonging to `scene`.
+    // Returns the number actually allocated which is less than requested only when out of memory.
+    //
+    std::size_t allocateEntities(std::size_t num_entities, Scene& scene, const StringRange& name, Entity** results);
 
-          for (std::uint16_t i = 0u; i < num_to_alloc_in_piece; ++i)
-          {
-            *results++ = piece->alloc(scene);
-          }
+    // IMemoryManager Interface
 
-          if (!num_to_alloc)
-          {
-            break;
-          }
-        }
-      }
+    void* allocate(std::size_t size) override;
+    void  deallocate(void* ptr, std::size_t num_bytes) override;
 
-      m_NumEntitiesLeft -= num_actual_alloc;
+    ~EntityStorage();
 
-      return num_actual_alloc;
-    }
-
-    void destroy()
-    {
-      for (EntityChunkPiece* piece : m_Pieces)
-      {
-        m_Memory.deallocateT(piece);
-      }
-    }
-  };
-
-  struct EntityHandle
-  {
-    EntityChunk*  chunk;
-    std::uint16_t instance_id;
-  };
-
-  class EntityStorage
-  {
    private:
-    List<EntityChunk> m_Chunks;
-    EntityIDToEntity  m_IDMapping;
-
-   public:
-    EntityStorage(IMemoryManager& memory) :
-      m_Chunks{memory},
-      m_IDMapping{}
-    {
-    }
+    bool growBy(std::size_t num_chunks);
   };
 }  // namespace bf
 
@@ -17,90 +17,286 @@
 #ifndef BF_BVH_HPP
 #define BF_BVH_HPP
 
+//
+// 16bit node offsets limit a tree to 65535 nodes (~32k leaves)
+// but keep the nodes smaller, 32bit offsets are used by default.
+//
+#ifndef BF_BVH_USE_16BIT_NODE_OFFSETS
+#define BF_BVH_USE_16BIT_NODE_OFFSETS 0
+#endif
+
 #include "bf/LinearAllocator.hpp"                // LinearAllocator
+#include "bf/bf_non_copy_move.hpp"               // NonCopyMoveable<T>
 #include "bf/asset_io/bf_model_loader.hpp"       // AABB
+#include "bf/core/bf_parallel_for.hpp"           // parallelForChunks
 #include "bf/data_structures/bifrost_array.hpp"  // Array<T>
+#include "bf/math/bifrost_camera.h"              // bfFrustum, bfRay3D
+
+#include <algorithm>    // partition, nth_element, clamp
+#include <cassert>      // assert
+#include <cfloat>       // FLT_MAX
+#include <cmath>        // fabsf
+#include <cstdint>      // uint16_t, uint32_t
+#include <cstring>      // memset, memcpy
+#include <limits>       // numeric_limits
+#include <type_traits>  // is_unsigned_v
 
-#include <cfloat>   // FLT_MAX
-#include <cstdint>  // uint16_t
+#if defined(_MSC_VER)
+#include <xmmintrin.h>  // _mm_prefetch
+#endif
 
 namespace bf
 {
-  using BVHNodeOffset = std::uint16_t;
-
-  static constexpr BVHNodeOffset k_BVHNodeInvalidOffset = 0xFFFFu;
   static constexpr float         k_BVHRotationBenefit   = 0.3f;
   static constexpr float         k_BVHMergeDownBenefit  = 0.35f;
   static constexpr float         k_BVHBoundsSkin        = 0.1f;
-
-  struct BVHNode final
+  static constexpr std::uint8_t  k_BVHAllPlanesMask     = (1u << k_bfPlaneIdx_Max) - 1u;
+  static constexpr int           k_BVHNumSAHBins        = 16;
+  static constexpr std::uint16_t k_BVHMaxSAHDepth       = 48;    //!< Past this depth `BVH::buildFromLeaves` splits at the median, skewed SAH splits could otherwise reach a depth of one per leaf.
+  static constexpr std::size_t   k_BVHBuildGrainSize    = 1024;  //!< Minimum number of leaves in a subtree built by a single job.
+  static constexpr std::size_t   k_BVHRayPacketSize     = 8;     //!< Number of rays `BVH::raycastPacket` traverses the tree with at once.
+
+  template<typename TNodeOffset>
+  struct BVHNodeT final
   {
+    using NodeOffset = TNodeOffset;
+
+    static_assert(std::is_unsigned_v<NodeOffset>, "The max value of the offset type is used as the null offset.");
+
+    static constexpr NodeOffset k_InvalidOffset = std::numeric_limits<NodeOffset>::max();
+
     union
     {
       struct
       {
         void*         user_data;    // Mapping back to the object.
         AABB          bounds;       // Bounds including children.
-        BVHNodeOffset children[2];  // isLeaf = children[0] == children[1] (aka both k_BVHNodeInvalidOffset)
-        BVHNodeOffset parent;       // Only needed by rotation code, so really leaves don't need this.
-        BVHNodeOffset depth;        // For avl rotation balancing.
-        bool          is_visible;   // TODO(SR): TEMP bool just for testing an idea.
+        NodeOffset    children[2];  // isLeaf = children[0] == children[1] (aka both k_InvalidOffset)
+        NodeOffset    parent;       // Only needed by rotation code, so really leaves don't need this.
+        std::uint16_t depth;        // For avl rotation balancing.
       };
-      BVHNodeOffset next;  // Freelist, can be union-ed with other data since if it is on the freelist then all node members are unused.
+      NodeOffset next;  // Freelist, can be union-ed with other data since if it is on the freelist then all node members are unused.
     };
   };
 
+  static_assert(sizeof(BVHNodeT<std::uint16_t>) <= 64, "A node should fit in a single cache line.");
+  static_assert(sizeof(BVHNodeT<std::uint32_t>) <= 64, "A node should fit in a single cache line.");
+
   namespace bvh_node
   {
-    static bool isNull(BVHNodeOffset index)
+    template<typename TNodeOffset>
+    static bool isNull(TNodeOffset index)
     {
-      return index == k_BVHNodeInvalidOffset;
+      return index == BVHNodeT<TNodeOffset>::k_InvalidOffset;
     }
 
-    static bool isLeaf(const BVHNode& node)
+    template<typename TNodeOffset>
+    static bool isLeaf(const BVHNodeT<TNodeOffset>& node)
     {
       const bool result = node.children[0] == node.children[1];
 
-      assert((!result || node.children[0] == k_BVHNodeInvalidOffset) && "Either they do not match or both children are k_BVHNodeInvalidOffset.");
+      assert((!result || node.children[0] == BVHNodeT<TNodeOffset>::k_InvalidOffset) && "Either they do not match or both children are k_InvalidOffset.");
 
       return result;
     }
+
+    //
+    // Hint to start loading a node that is about to be visited,
+    // helps hide the cache miss of jumping around the node array.
+    //
+    inline void prefetch(const void* node)
+    {
+#if defined(_MSC_VER)
+      _mm_prefetch(static_cast<const char*>(node), _MM_HINT_T0);
+#elif defined(__GNUC__) || defined(__clang__)
+      __builtin_prefetch(node);
+#else
+      (void)node;
+#endif
+    }
   }  // namespace bvh_node
 
-  struct BVH final
+  //
+  // Stack for the non recursive traversals of the tree,
+  // the heap is only touched once the tree is deeper than `k_InlineSize`.
+  //
+  template<typename T, std::size_t k_InlineSize = 64>
+  class BVHTraversalStack final : private NonCopyMoveable<BVHTraversalStack<T, k_InlineSize>>
   {
-    Array<BVHNode>       nodes;
-    Array<BVHNodeOffset> nodes_to_optimize;
-    BVHNodeOffset        root_idx;
-    BVHNodeOffset        freelist;
-    std::uint16_t        max_depth_;
+    static_assert(std::is_trivially_copyable_v<T>, "Elements are grown with a memcpy.");
+
+   private:
+    IMemoryManager& m_Memory;
+    T               m_InlineItems[k_InlineSize];
+    T*              m_Items;
+    std::size_t     m_Size;
+    std::size_t     m_Capacity;
+
+   public:
+    explicit BVHTraversalStack(IMemoryManager& memory) :
+      m_Memory{memory},
+      m_InlineItems{},
+      m_Items{m_InlineItems},
+      m_Size{0},
+      m_Capacity{k_InlineSize}
+    {
+    }
+
+    bool isEmpty() const { return m_Size == 0; }
+
+    void push(const T& item)
+    {
+      if (m_Size == m_Capacity)
+      {
+        grow();
+      }
+
+      m_Items[m_Size++] = item;
+    }
+
+    T pop()
+    {
+      assert(!isEmpty() && "Cannot pop from an empty stack.");
+
+      return m_Items[--m_Size];
+    }
+
+    ~BVHTraversalStack()
+    {
+      if (m_Items != m_InlineItems)
+      {
+        m_Memory.deallocate(m_Items, sizeof(T) * m_Capacity);
+      }
+    }
+
+   private:
+    void grow()
+    {
+      const std::size_t new_capacity = m_Capacity * 2;
+      T* const          new_items    = static_cast<T*>(m_Memory.allocate(sizeof(T) * new_capacity));
+
+      std::memcpy(new_items, m_Items, sizeof(T) * m_Size);
+
+      if (m_Items != m_InlineItems)
+      {
+        m_Memory.deallocate(m_Items, sizeof(T) * m_Capacity);
+      }
+
+      m_Items    = new_items;
+      m_Capacity = new_capacity;
+    }
+  };
+
+  struct BVHRayHit final
+  {
+    bool        did_hit;    // Check this to see if the ray hit anything.
+    float       time;       // Distance along the ray, undefined if `did_hit` is false.
+    void*       user_data;  // The `user_data` of the leaf that was hit.
+    std::size_t node;       // The leaf that was hit.
+  };
+
+  struct BVHLeaf final
+  {
+    void* user_data;  // Mapping back to the object.
+    AABB  bounds;     // Bounds of the object, the skin is added by `BVH::buildFromLeaves`.
+  };
+
+  //
+  // Output of `BVH::cullFrustum`, kept outside of the tree so
+  // that each view can cull the same tree without stomping on each other.
+  //
+  struct BVHCullingState final
+  {
+    Array<std::uint32_t> visible_bits;        //!< One bit per node in `BVH::nodes`, set if the node is at least partially inside the frustum.
+    Array<std::uint8_t>  last_culled_plane;   //!< Per node, the plane that last culled it, it is tested first since it will most likely cull it again.
+    Array<std::uint32_t> leaf_batch;          //!< Leaves reached with planes still left to test, these are culled together after the traversal.
+    Array<float>         leaf_batch_bounds;   //!< Bounds of `leaf_batch` as six arrays (min xyz, max xyz) of `leaf_batch.size()` floats.
+    Array<std::uint32_t> leaf_batch_visible;  //!< One bit per `leaf_batch` element, output of `bfFrustum_cullAABBs`.
+
+    explicit BVHCullingState(IMemoryManager& memory) :
+      visible_bits{memory},
+      last_culled_plane{memory},
+      leaf_batch{memory},
+      leaf_batch_bounds{memory},
+      leaf_batch_visible{memory}
+    {
+    }
+
+    bool isVisible(std::size_t node) const
+    {
+      return (node >> 5) < visible_bits.size() && (visible_bits[node >> 5] & (1u << (node & 31u))) != 0u;
+    }
+
+    void markVisible(std::size_t node)
+    {
+      visible_bits[node >> 5] |= 1u << (node & 31u);
+    }
+  };
+
+  template<typename TNodeOffset>
+  struct BVHT final
+  {
+    using NodeOffset = TNodeOffset;
+    using Node       = BVHNodeT<TNodeOffset>;
+
+    static constexpr NodeOffset k_InvalidOffset = Node::k_InvalidOffset;
+
+    Array<Node>       nodes;
+    Array<NodeOffset> nodes_to_optimize;
+    NodeOffset        root_idx;
+    NodeOffset        freelist;
+    std::uint16_t     max_depth_;
 
-    explicit BVH(IMemoryManager& memory) :
+    explicit BVHT(IMemoryManager& memory) :
       nodes{memory},
       nodes_to_optimize{memory},
-      root_idx{k_BVHNodeInvalidOffset},
-      freelist{k_BVHNodeInvalidOffset},
+      root_idx{k_InvalidOffset},
+      freelist{k_InvalidOffset},
       max_depth_{0}
     {
     }
 
+    //
+    // Calls `bool callback(Node&)` on \p node and its descendants (parents before children),
+    // the children of a node are only visited if the callback returns true for it.
+    //
     template<typename F>
-    void traverseConditionally(BVHNodeOffset node, F&& callback)
+    void traverseConditionally(NodeOffset node, F&& callback)
     {
-      if (!bvh_node::isNull(node))
+      if (bvh_node::isNull(node))
       {
-        if (callback(nodes[node]) && !bvh_node::isLeaf(nodes[node]))
+        return;
+      }
+
+      BVHTraversalStack<NodeOffset> stack{nodes.memory()};
+
+      stack.push(node);
+
+      while (!stack.isEmpty())
+      {
+        NodeOffset current_idx = stack.pop();
+
+        // Descends down the left side directly, only the right children go through the stack.
+        while (true)
         {
-          traverseConditionally(nodes[node].children[0], callback);
-          traverseConditionally(nodes[node].children[1], callback);
+          Node& current = nodes[current_idx];
+
+          if (!callback(current) || bvh_node::isLeaf(current))
+          {
+            break;
+          }
+
+          bvh_node::prefetch(&nodes[current.children[1]]);
+          stack.push(current.children[1]);
+          current_idx = current.children[0];
         }
       }
     }
 
     template<typename F>
-    void traverse(BVHNodeOffset node, F&& callback)
+    void traverse(NodeOffset node, F&& callback)
     {
-      traverseConditionally(node, [&callback](BVHNode& node) -> bool {
+      traverseConditionally(node, [&callback](Node& node) -> bool {
         callback(node);
         return true;
       });
@@ -118,25 +314,25 @@ namespace bf
       traverseConditionally(root_idx, callback);
     }
 
-    BVHNodeOffset insert(void* user_data, const AABB& bounds)
+    NodeOffset insert(void* user_data, const AABB& bounds)
     {
       const AABB object_bounds = aabb::expandedBy(bounds, k_BVHBoundsSkin);
 
       if (!bvh_node::isNull(root_idx))
       {
         // Stage 1: Look for best leaf to be a sibling of.
-        const BVHNode* current_node = &nodeAt(root_idx);
+        const Node* current_node = &nodeAt(root_idx);
 
         while (!bvh_node::isLeaf(*current_node))
         {
-          const BVHNode& left            = nodeAt(current_node->children[0]);
-          const BVHNode& right           = nodeAt(current_node->children[1]);
-          const float    left_sa         = aabb::surfaceArea(left.bounds);
-          const float    right_sa        = aabb::surfaceArea(right.bounds);
-          AABB           add_to_left     = aabb::mergeBounds(left.bounds, object_bounds);
-          AABB           add_to_right    = aabb::mergeBounds(right.bounds, object_bounds);
-          const float    add_to_left_sa  = aabb::surfaceArea(add_to_left) + right_sa;
-          const float    add_to_right_sa = aabb::surfaceArea(add_to_right) + left_sa;
+          const Node& left            = nodeAt(current_node->children[0]);
+          const Node& right           = nodeAt(current_node->children[1]);
+          const float left_sa         = aabb::surfaceArea(left.bounds);
+          const float right_sa        = aabb::surfaceArea(right.bounds);
+          AABB        add_to_left     = aabb::mergeBounds(left.bounds, object_bounds);
+          AABB        add_to_right    = aabb::mergeBounds(right.bounds, object_bounds);
+          const float add_to_left_sa  = aabb::surfaceArea(add_to_left) + right_sa;
+          const float add_to_right_sa = aabb::surfaceArea(add_to_right) + left_sa;
 
           if (add_to_left_sa < add_to_right_sa)
           {
@@ -149,11 +345,11 @@ namespace bf
         }
 
         // Stage 2: Add the Object as normal
-        const BVHNodeOffset sibling    = nodeToIndex(*current_node);
-        const BVHNodeOffset old_parent = current_node->parent;
-        const BVHNodeOffset old_depth  = current_node->depth;
-        const BVHNodeOffset new_parent = createNode(nullptr, AABB(Vector3f{0.0f}, Vector3f{0.0f}));
-        const BVHNodeOffset new_leaf   = createNode(user_data, object_bounds);
+        const NodeOffset    sibling    = nodeToIndex(*current_node);
+        const NodeOffset    old_parent = current_node->parent;
+        const std::uint16_t old_depth  = current_node->depth;
+        const NodeOffset    new_parent = createNode(nullptr, AABB(Vector3f{0.0f}, Vector3f{0.0f}));
+        const NodeOffset    new_leaf   = createNode(user_data, object_bounds);
 
         nodes[new_parent].children[0] = sibling;
         nodes[new_parent].children[1] = new_leaf;
@@ -188,8 +384,96 @@ namespace bf
       return root_idx;
     }
 
+    /*!
+     * @brief
+     *   Replaces the contents of this tree with one built top down from all of \p leaves
+     *   using a binned surface area heuristic, this gives a much better tree than
+     *   inserting each leaf one by one.
+     *
+     *   Nodes are laid out depth first with a subtree of N leaves using exactly 2N - 1 nodes,
+     *   this allows subtrees to be built by the job system without any synchronization.
+     *
+     *   References:
+     *     [https://www.sci.utah.edu/~wald/Publications/2007/ParallelBVHBuild/fastbuild.pdf]
+     *
+     * @param leaves
+     *   The objects to add to the tree.
+     *
+     * @param num_leaves
+     *   The number of elements in \p leaves.
+     *
+     * @param out_leaf_nodes
+     *   Must have room for \p num_leaves elements, `out_leaf_nodes[i]` is the leaf node of `leaves[i]`.
+     *
+     * @param temp_memory
+     *   Pass in a nice and fast allocator for the build's scratch memory.
+    */
+    void buildFromLeaves(const BVHLeaf* leaves, std::size_t num_leaves, NodeOffset* out_leaf_nodes, LinearAllocator& temp_memory)
+    {
+      nodes.clear();
+      nodes_to_optimize.clear();
+      root_idx   = k_InvalidOffset;
+      freelist   = k_InvalidOffset;
+      max_depth_ = 0;
+
+      if (!num_leaves)
+      {
+        return;
+      }
+
+      const std::size_t num_nodes = num_leaves * 2 - 1;
+
+      assert(num_nodes < k_InvalidOffset && "Too many leaves for this tree's 'NodeOffset' to address.");
+
+      nodes.resize(num_nodes);
+
+      LinearAllocatorScope mem_scope  = {temp_memory};
+      BuildRef* const      refs       = temp_memory.allocateArrayTrivial<BuildRef>(num_leaves);
+      BuildTask* const     tasks      = temp_memory.allocateArrayTrivial<BuildTask>(num_leaves);
+      const std::size_t    split_size = std::max(k_BVHBuildGrainSize, num_leaves / parallelChunkCount(num_leaves, k_BVHBuildGrainSize));
+
+      for (std::size_t i = 0; i < num_leaves; ++i)
+      {
+        BuildRef& ref = refs[i];
+
+        ref.bounds = aabb::expandedBy(leaves[i].bounds, k_BVHBoundsSkin);
+        ref.leaf   = std::uint32_t(i);
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          ref.centroid[axis] = (ref.bounds.min[axis] + ref.bounds.max[axis]) * 0.5f;
+        }
+      }
+
+      BuildContext ctx = {leaves, refs, out_leaf_nodes, tasks, 0u, split_size};
+
+      // Stage 1: Build the top of the tree, deferring subtrees small enough for a single job.
+
+      root_idx = 0;
+      buildRange(ctx, root_idx, k_InvalidOffset, 0, 0, num_leaves, true);
+
+      // Stage 2: Build the deferred subtrees in parallel.
+
+      parallelForChunks(
+       ctx.num_tasks,
+       parallelChunkCount(ctx.num_tasks, 1),
+       [this, &ctx](std::size_t /* chunk_index */, std::size_t task_bgn, std::size_t task_end) {
+         for (std::size_t i = task_bgn; i < task_end; ++i)
+         {
+           const BuildTask& task = ctx.tasks[i];
+
+           buildRange(ctx, task.node, task.parent, task.depth, task.ref_bgn, task.ref_end, false);
+         }
+       });
+
+      for (const Node& node : nodes)
+      {
+        max_depth_ = std::max(max_depth_, node.depth);
+      }
+    }
+
     // Call when the object associated with this leaf has moved.
-    void markLeafDirty(BVHNodeOffset leaf, const AABB& bounds)
+    void markLeafDirty(NodeOffset leaf, const AABB& bounds)
     {
       assert(bvh_node::isLeaf(nodes[leaf]) && "Only leaf nodes can be passed into this function.");
 
@@ -204,21 +488,21 @@ namespace bf
       }
     }
 
-    void remove(BVHNodeOffset leaf)
+    void remove(NodeOffset leaf)
     {
       addToFreelist(leaf);
 
       if (leaf == root_idx)
       {
-        root_idx = k_BVHNodeInvalidOffset;
+        root_idx = k_InvalidOffset;
         return;
       }
 
-      const BVHNodeOffset parent          = nodes[leaf].parent;
-      const BVHNodeOffset grandparent     = nodes[parent].parent;
-      const auto          parent_depth    = nodes[parent].depth;
-      const bool          has_grandparent = !bvh_node::isNull(grandparent);
-      const BVHNodeOffset sibling         = nodes[parent].children[(leaf == nodes[parent].children[0] ? 1 : 0)];
+      const NodeOffset parent          = nodes[leaf].parent;
+      const NodeOffset grandparent     = nodes[parent].parent;
+      const auto       parent_depth    = nodes[parent].depth;
+      const bool       has_grandparent = !bvh_node::isNull(grandparent);
+      const NodeOffset sibling         = nodes[parent].children[(leaf == nodes[parent].children[0] ? 1 : 0)];
 
       assert(nodes[parent].children[0] == leaf || nodes[parent].children[1] == leaf);
 
@@ -263,8 +547,8 @@ namespace bf
     {
       struct OffsetIndexPair final
       {
-        BVHNodeOffset node;   // Index into BVH::nodes
-        BVHNodeOffset index;  // Index into BVH::nodes_to_optimize
+        NodeOffset node;   // Index into BVH::nodes
+        NodeOffset index;  // Index into BVH::nodes_to_optimize
       };
 
       while (!nodes_to_optimize.isEmpty())
@@ -281,8 +565,8 @@ namespace bf
 
         for (int i = 1; i < num_nodes; ++i)
         {
-          const BVHNodeOffset node_offset = nodes_to_optimize[i];
-          auto&               node_at_i   = nodeAt(node_offset);
+          const NodeOffset node_offset = nodes_to_optimize[i];
+          auto&            node_at_i   = nodeAt(node_offset);
 
           if (max_depth > node_at_i.depth)
           {
@@ -295,21 +579,21 @@ namespace bf
             num_max_depth_nodes = 0;
           }
 
-          max_depth_nodes[num_max_depth_nodes++] = {node_offset, static_cast<BVHNodeOffset>(i)};
+          max_depth_nodes[num_max_depth_nodes++] = {node_offset, static_cast<NodeOffset>(i)};
         }
 
         // Stage 2: Clear out the level we will be evaluating.
 
         for (int i = 0; i < num_max_depth_nodes; ++i)
         {
-          nodes_to_optimize[max_depth_nodes[i].index] = k_BVHNodeInvalidOffset;
+          nodes_to_optimize[max_depth_nodes[i].index] = k_InvalidOffset;
         }
 
         auto* const split = std::partition(
          nodes_to_optimize.begin(),
          nodes_to_optimize.end(),
-         [](const BVHNodeOffset element) -> bool {
-           return element < k_BVHNodeInvalidOffset;
+         [](const NodeOffset element) -> bool {
+           return element < k_InvalidOffset;
          });
 
         const std::size_t new_size = split - nodes_to_optimize.begin();
@@ -320,9 +604,9 @@ namespace bf
 
         for (int i = 0; i < num_max_depth_nodes; ++i)
         {
-          BVHNode& node    = nodeAt(max_depth_nodes[i].node);
-          BVHNode& child_l = nodeAt(node.children[0]);
-          BVHNode& child_r = nodeAt(node.children[1]);
+          Node& node    = nodeAt(max_depth_nodes[i].node);
+          Node& child_l = nodeAt(node.children[0]);
+          Node& child_r = nodeAt(node.children[1]);
 
           if (bvh_node::isLeaf(child_l) && bvh_node::isLeaf(child_r))
           {
@@ -361,10 +645,10 @@ namespace bf
 
           if (!bvh_node::isLeaf(child_r))
           {
-            BVHNode& right_left  = nodeAt(child_r.children[0]);
-            BVHNode& right_right = nodeAt(child_r.children[1]);
-            AABB     aabb_lrr;  // NOLINT
-            AABB     aabb_lrl;  // NOLINT
+            Node& right_left  = nodeAt(child_r.children[0]);
+            Node& right_right = nodeAt(child_r.children[1]);
+            AABB  aabb_lrr;  // NOLINT
+            AABB  aabb_lrl;  // NOLINT
 
             aabb::mergeBounds(aabb_lrr, child_l.bounds, right_right.bounds);
             aabb::mergeBounds(aabb_lrl, child_l.bounds, right_left.bounds);
@@ -382,10 +666,10 @@ namespace bf
 
           if (!bvh_node::isLeaf(child_l))
           {
-            BVHNode& left_left  = nodeAt(child_l.children[0]);
-            BVHNode& left_right = nodeAt(child_l.children[1]);
-            AABB     aabb_rlr;  // NOLINT
-            AABB     aabb_rll;  // NOLINT
+            Node& left_left  = nodeAt(child_l.children[0]);
+            Node& left_right = nodeAt(child_l.children[1]);
+            AABB  aabb_rlr;  // NOLINT
+            AABB  aabb_rll;  // NOLINT
 
             aabb::mergeBounds(aabb_rlr, child_r.bounds, left_right.bounds);
             aabb::mergeBounds(aabb_rll, child_r.bounds, left_left.bounds);
@@ -403,14 +687,14 @@ namespace bf
 
           if (!bvh_node::isLeaf(child_l) && !bvh_node::isLeaf(child_r))
           {
-            BVHNode& left_left   = nodeAt(child_l.children[0]);
-            BVHNode& left_right  = nodeAt(child_l.children[1]);
-            BVHNode& right_left  = nodeAt(child_r.children[0]);
-            BVHNode& right_right = nodeAt(child_r.children[1]);
-            AABB     aabb_rrlr;  // NOLINT
-            AABB     aabb_rlll;  // NOLINT
-            AABB     aabb_rllr;  // NOLINT
-            AABB     aabb_llrr;  // NOLINT
+            Node& left_left   = nodeAt(child_l.children[0]);
+            Node& left_right  = nodeAt(child_l.children[1]);
+            Node& right_left  = nodeAt(child_r.children[0]);
+            Node& right_right = nodeAt(child_r.children[1]);
+            AABB  aabb_rrlr;  // NOLINT
+            AABB  aabb_rlll;  // NOLINT
+            AABB  aabb_rllr;  // NOLINT
+            AABB  aabb_llrr;  // NOLINT
 
             aabb::mergeBounds(aabb_rrlr, right_right.bounds, left_right.bounds);
             aabb::mergeBounds(aabb_rlll, right_left.bounds, left_left.bounds);
@@ -432,7 +716,7 @@ namespace bf
 
           for (int j = 1; j < num_rotation_candidates; ++j)
           {
-            if (rotation_candidates[i] < rotation_candidates[int(best_candidate)])
+            if (rotation_candidates[j] < rotation_candidates[int(best_candidate)])
             {
               best_candidate = RotationOp(j);
             }
@@ -459,14 +743,14 @@ namespace bf
               continue;
             }
 
-            const BVHNodeOffset self_idx = nodeToIndex(node);
+            const NodeOffset self_idx = nodeToIndex(node);
 
             switch (best_candidate)
             {
               case RotationOp::L_RL:
               {
-                const BVHNodeOffset swap       = nodeToIndex(child_l);
-                BVHNode&            right_left = nodeAt(child_r.children[0]);
+                const NodeOffset swap       = nodeToIndex(child_l);
+                Node&            right_left = nodeAt(child_r.children[0]);
 
                 adoptNode(self_idx, nodeToIndex(right_left), 0);
                 adoptNode(nodeToIndex(child_r), swap, 0);
@@ -476,8 +760,8 @@ namespace bf
               }
               case RotationOp::L_RR:
               {
-                const BVHNodeOffset swap        = nodeToIndex(child_l);
-                BVHNode&            right_right = nodeAt(child_r.children[1]);
+                const NodeOffset swap        = nodeToIndex(child_l);
+                Node&            right_right = nodeAt(child_r.children[1]);
 
                 adoptNode(self_idx, nodeToIndex(right_right), 0);
                 adoptNode(nodeToIndex(child_r), swap, 1);
@@ -487,8 +771,8 @@ namespace bf
               }
               case RotationOp::R_LL:
               {
-                const BVHNodeOffset swap      = nodeToIndex(child_r);
-                BVHNode&            left_left = nodeAt(child_l.children[0]);
+                const NodeOffset swap      = nodeToIndex(child_r);
+                Node&            left_left = nodeAt(child_l.children[0]);
 
                 adoptNode(self_idx, nodeToIndex(left_left), 1);
                 adoptNode(nodeToIndex(child_l), swap, 0);
@@ -498,8 +782,8 @@ namespace bf
               }
               case RotationOp::R_LR:
               {
-                const BVHNodeOffset swap       = nodeToIndex(child_r);
-                BVHNode&            left_right = nodeAt(child_l.children[1]);
+                const NodeOffset swap       = nodeToIndex(child_r);
+                Node&            left_right = nodeAt(child_l.children[1]);
 
                 adoptNode(self_idx, nodeToIndex(left_right), 1);
                 adoptNode(nodeToIndex(child_l), swap, 1);
@@ -509,9 +793,9 @@ namespace bf
               }
               case RotationOp::LL_RR:
               {
-                BVHNode&            right_right = nodeAt(child_r.children[1]);
-                BVHNode&            left_left   = nodeAt(child_l.children[0]);
-                const BVHNodeOffset swap        = nodeToIndex(left_left);
+                Node&            right_right = nodeAt(child_r.children[1]);
+                Node&            left_left   = nodeAt(child_l.children[0]);
+                const NodeOffset swap        = nodeToIndex(left_left);
 
                 adoptNode(nodeToIndex(child_l), nodeToIndex(right_right), 0);
                 adoptNode(nodeToIndex(child_r), swap, 1);
@@ -521,9 +805,9 @@ namespace bf
               }
               case RotationOp::LL_RL:
               {
-                BVHNode&            left_left  = nodeAt(child_l.children[0]);
-                BVHNode&            right_left = nodeAt(child_r.children[0]);
-                const BVHNodeOffset swap       = nodeToIndex(left_left);
+                Node&            left_left  = nodeAt(child_l.children[0]);
+                Node&            right_left = nodeAt(child_r.children[0]);
+                const NodeOffset swap       = nodeToIndex(left_left);
 
                 adoptNode(nodeToIndex(child_l), nodeToIndex(right_left), 0);
                 adoptNode(nodeToIndex(child_r), swap, 0);
@@ -542,86 +826,889 @@ namespace bf
       }
     }
 
-    BVHNode& nodeAt(BVHNodeOffset index)
+    /*!
+     * @brief
+     *   Marks every node that is at least partially inside of \p frustum as visible in \p state.
+     *
+     *   Each node only tests the planes that its parent was not completely inside of
+     *   and a subtree completely inside the frustum is marked without any more plane tests.
+     *   Subtrees that are outside are skipped entirely.
+     *
+     *   Leaves that still need testing are gathered and culled in one batch by
+     *   `bfFrustum_cullAABBs`, they are about half of the nodes in the tree.
+     *
+     *   References:
+     *     [https://cesium.com/blog/2015/08/04/fast-hierarchical-culling/]
+     *
+     * @param frustum
+     *   The frustum to cull against.
+     *
+     * @param state
+     *   Where the results are written, should be kept around between frames
+     *   since it caches the plane that culled each node last time.
+    */
+    void cullFrustum(const bfFrustum& frustum, BVHCullingState& state) const
+    {
+      const std::size_t num_nodes = nodes.size();
+
+      state.visible_bits.resize((num_nodes + 31) / 32);
+      std::memset(state.visible_bits.data(), 0x0, state.visible_bits.size() * sizeof(std::uint32_t));
+
+      if (state.last_culled_plane.size() < num_nodes)
+      {
+        state.last_culled_plane.resize(num_nodes);
+      }
+
+      if (!bvh_node::isNull(root_idx))
+      {
+        CullPlanes planes;  // NOLINT
+
+        for (int i = 0; i < k_bfPlaneIdx_Max; ++i)
+        {
+          const bfPlane& plane = frustum.planes[i];
+
+          planes.normal[i][0]     = plane.nx;
+          planes.normal[i][1]     = plane.ny;
+          planes.normal[i][2]     = plane.nz;
+          planes.abs_normal[i][0] = std::fabs(plane.nx);
+          planes.abs_normal[i][1] = std::fabs(plane.ny);
+          planes.abs_normal[i][2] = std::fabs(plane.nz);
+          planes.d[i]             = plane.d;
+        }
+
+        state.leaf_batch.clear();
+
+        cullNodes(planes, state);
+        cullLeafBatch(frustum, state);
+      }
+    }
+
+    /*!
+     * @brief
+     *   Finds the closest leaf along \p ray, nodes farther than the
+     *   closest hit so far are skipped and nearer children are visited first.
+     *
+     * @param ray
+     *   Must have been made with `bfRay3D_make`.
+     *
+     * @param max_time
+     *   Hits farther along the ray than this are ignored.
+     *
+     * @param leaf_test
+     *   `float(const Node& leaf, float aabb_time)`, called for each leaf whose bounds
+     *   the ray enters at `aabb_time`, returns the exact hit time or `FLT_MAX` on a miss.
+     *
+     * @return
+     *   The closest hit.
+    */
+    template<typename F>
+    BVHRayHit raycast(const bfRay3D& ray, float max_time, F&& leaf_test) const
+    {
+      struct StackEntry final
+      {
+        NodeOffset node;
+        float      time;  // Time the ray enters the node.
+      };
+
+      BVHRayHit     result = {false, max_time, nullptr, k_InvalidOffset};
+      const RayInfo info   = rayInfo(ray);
+      float         time;
+
+      if (bvh_node::isNull(root_idx) || !rayVsBounds(info, nodes[root_idx].bounds, max_time, time))
+      {
+        return result;
+      }
+
+      BVHTraversalStack<StackEntry> stack{nodes.memory()};
+
+      stack.push({root_idx, time});
+
+      while (!stack.isEmpty())
+      {
+        const StackEntry entry = stack.pop();
+
+        if (entry.time >= result.time)
+        {
+          continue;
+        }
+
+        const Node& node = nodes[entry.node];
+
+        if (bvh_node::isLeaf(node))
+        {
+          const float hit_time = leaf_test(node, entry.time);
+
+          if (hit_time < result.time)
+          {
+            result.did_hit   = true;
+            result.time      = hit_time;
+            result.user_data = node.user_data;
+            result.node      = entry.node;
+          }
+
+          continue;
+        }
+
+        StackEntry children[2];
+        int        num_children = 0;
+
+        for (const NodeOffset child : node.children)
+        {
+          if (rayVsBounds(info, nodes[child].bounds, result.time, time))
+          {
+            children[num_children++] = {child, time};
+          }
+        }
+
+        // The nearer child is pushed last so that it is visited first.
+        if (num_children == 2 && children[0].time < children[1].time)
+        {
+          std::swap(children[0], children[1]);
+        }
+
+        for (int i = 0; i < num_children; ++i)
+        {
+          stack.push(children[i]);
+        }
+      }
+
+      return result;
+    }
+
+    // Closest hit against the bounds of the leaves.
+    BVHRayHit raycast(const bfRay3D& ray, float max_time = FLT_MAX) const
+    {
+      return raycast(ray, max_time, [](const Node&, float aabb_time) -> float {
+        return aabb_time;
+      });
+    }
+
+    /*!
+     * @brief
+     *   Raycasts a batch of rays, rays are traversed in packets of `k_BVHRayPacketSize`
+     *   that share a traversal so that coherent rays (same origin, similar direction)
+     *   load each node once per packet rather than once per ray.
+     *
+     * @param rays
+     *   Each must have been made with `bfRay3D_make`.
+     *
+     * @param num_rays
+     *   The number of elements in \p rays.
+     *
+     * @param max_time
+     *   Hits farther along each ray than this are ignored.
+     *
+     * @param out_hits
+     *   Must have room for \p num_rays elements, `out_hits[i]` is the closest hit of `rays[i]`.
+     *
+     * @param leaf_test
+     *   `float(const Node& leaf, std::size_t ray_index, float aabb_time)`,
+     *   same as the single ray version but also given the index of the ray.
+    */
+    template<typename F>
+    void raycastPacket(const bfRay3D* rays, std::size_t num_rays, float max_time, BVHRayHit* out_hits, F&& leaf_test) const
+    {
+      struct StackEntry final
+      {
+        NodeOffset    node;
+        std::uint32_t ray_mask;  // The rays in the packet that enter the node.
+      };
+
+      static_assert(k_BVHRayPacketSize <= 32, "The ray mask must be able to hold the whole packet.");
+
+      for (std::size_t packet_bgn = 0; packet_bgn < num_rays; packet_bgn += k_BVHRayPacketSize)
+      {
+        const std::size_t packet_size = std::min(k_BVHRayPacketSize, num_rays - packet_bgn);
+        BVHRayHit* const  hits        = out_hits + packet_bgn;
+        RayInfo           infos[k_BVHRayPacketSize];
+
+        for (std::size_t i = 0; i < packet_size; ++i)
+        {
+          infos[i] = rayInfo(rays[packet_bgn + i]);
+          hits[i]  = {false, max_time, nullptr, k_InvalidOffset};
+        }
+
+        if (bvh_node::isNull(root_idx))
+        {
+          continue;
+        }
+
+        BVHTraversalStack<StackEntry> stack{nodes.memory()};
+
+        stack.push({root_idx, (1u << packet_size) - 1u});
+
+        while (!stack.isEmpty())
+        {
+          const StackEntry entry    = stack.pop();
+          const Node&      node     = nodes[entry.node];
+          std::uint32_t    ray_mask = 0u;
+          float            times[k_BVHRayPacketSize];
+
+          for (std::size_t i = 0; i < packet_size; ++i)
+          {
+            if (entry.ray_mask & (1u << i) && rayVsBounds(infos[i], node.bounds, hits[i].time, times[i]))
+            {
+              ray_mask |= 1u << i;
+            }
+          }
+
+          if (!ray_mask)
+          {
+            continue;
+          }
+
+          if (bvh_node::isLeaf(node))
+          {
+            for (std::size_t i = 0; i < packet_size; ++i)
+            {
+              if (ray_mask & (1u << i))
+              {
+                const float hit_time = leaf_test(node, packet_bgn + i, times[i]);
+
+                if (hit_time < hits[i].time)
+                {
+                  hits[i].did_hit   = true;
+                  hits[i].time      = hit_time;
+                  hits[i].user_data = node.user_data;
+                  hits[i].node      = entry.node;
+                }
+              }
+            }
+
+            continue;
+          }
+
+          // Visit the child nearer to the first active ray first.
+
+          const std::size_t first_ray = lowestBitIndex(ray_mask);
+          const RayInfo&    lead_ray  = infos[first_ray];
+          const AABB&       bounds_l  = nodes[node.children[0]].bounds;
+          const AABB&       bounds_r  = nodes[node.children[1]].bounds;
+          float             l_to_r    = 0.0f;
+
+          for (int axis = 0; axis < 3; ++axis)
+          {
+            l_to_r += lead_ray.direction[axis] * ((bounds_r.min[axis] + bounds_r.max[axis]) - (bounds_l.min[axis] + bounds_l.max[axis]));
+          }
+
+          const int near_child = l_to_r >= 0.0f ? 0 : 1;
+
+          stack.push({node.children[1 - near_child], ray_mask});
+          stack.push({node.children[near_child], ray_mask});
+        }
+      }
+    }
+
+    /*!
+     * @brief
+     *   Calls \p callback with each leaf whose bounds overlap \p bounds.
+     *
+     * @param callback
+     *   `void(const Node& leaf)`
+    */
+    template<typename F>
+    void overlapAABB(const AABB& bounds, F&& callback) const
+    {
+      overlapQuery(
+       [&bounds](const AABB& node_bounds) -> bool {
+         for (int i = 0; i < 3; ++i)
+         {
+           if (node_bounds.max[i] < bounds.min[i] || node_bounds.min[i] > bounds.max[i])
+           {
+             return false;
+           }
+         }
+
+         return true;
+       },
+       callback);
+    }
+
+    /*!
+     * @brief
+     *   Calls \p callback with each leaf whose bounds overlap the sphere.
+     *
+     * @param callback
+     *   `void(const Node& leaf)`
+    */
+    template<typename F>
+    void overlapSphere(const Vector3f& center, float radius, F&& callback) const
+    {
+      const float sphere_center[3] = {center.x, center.y, center.z};
+      const float radius_sq        = radius * radius;
+
+      overlapQuery(
+       [&sphere_center, radius_sq](const AABB& node_bounds) -> bool {
+         float distance_sq = 0.0f;
+
+         // Distance from the sphere's center to the closest point on the box.
+         for (int i = 0; i < 3; ++i)
+         {
+           const float closest_point = std::clamp(sphere_center[i], node_bounds.min[i], node_bounds.max[i]);
+           const float delta         = sphere_center[i] - closest_point;
+
+           distance_sq += delta * delta;
+         }
+
+         return distance_sq <= radius_sq;
+       },
+       callback);
+    }
+
+    Node& nodeAt(NodeOffset index)
     {
       return nodes[index];
     }
 
-    BVHNodeOffset nodeToIndex(const BVHNode& node) const
+    NodeOffset nodeToIndex(const Node& node) const
     {
-      return BVHNodeOffset(&node - nodes.data());
+      return NodeOffset(&node - nodes.data());
     }
 
    private:
-    void addNodeToRefit(BVHNodeOffset node)
+    struct RayInfo final
     {
-      nodes_to_optimize.push(node);
+      float origin[3];
+      float direction[3];
+      float inv_direction[3];
+    };
+
+    static RayInfo rayInfo(const bfRay3D& ray)
+    {
+      return {
+       {ray.origin.x, ray.origin.y, ray.origin.z},
+       {ray.direction.x, ray.direction.y, ray.direction.z},
+       {ray.inv_direction.x, ray.inv_direction.y, ray.inv_direction.z},
+      };
     }
 
-    void adoptNode(BVHNodeOffset self, BVHNodeOffset child, int index)
+    // Slab test, `out_time` is where the ray enters the box (clamped to zero if the origin is inside of it).
+    static bool rayVsBounds(const RayInfo& ray, const AABB& bounds, float max_time, float& out_time)
     {
-      nodes[self].children[index] = child;
-      nodes[child].parent         = self;
+      float t_min = 0.0f;
+      float t_max = max_time;
+
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        const float t0 = (bounds.min[axis] - ray.origin[axis]) * ray.inv_direction[axis];
+        const float t1 = (bounds.max[axis] - ray.origin[axis]) * ray.inv_direction[axis];
+
+        t_min = std::max(t_min, std::min(t0, t1));
+        t_max = std::min(t_max, std::max(t0, t1));
+      }
+
+      out_time = t_min;
+
+      return t_min <= t_max;
     }
 
-    bool refitChildren(BVHNodeOffset self, bool propagate)
+    static std::size_t lowestBitIndex(std::uint32_t mask)
     {
-      BVHNode& node = nodeAt(self);
+      std::size_t index = 0;
 
-      assert(!bvh_node::isLeaf(node) && "Only nodes with children can be passed to this function.");
+      while (!(mask & 1u))
+      {
+        mask >>= 1;
+        ++index;
+      }
 
-      const AABB new_bounds = aabb::mergeBounds(nodes[node.children[0]].bounds, nodes[node.children[1]].bounds);
+      return index;
+    }
 
-      if (node.bounds != new_bounds)
+    template<typename FOverlaps, typename F>
+    void overlapQuery(FOverlaps&& overlaps, F&& callback) const
+    {
+      if (bvh_node::isNull(root_idx))
       {
-        node.bounds = new_bounds;
+        return;
+      }
+
+      BVHTraversalStack<NodeOffset> stack{nodes.memory()};
 
-        if (propagate && !bvh_node::isNull(node.parent))
+      stack.push(root_idx);
+
+      while (!stack.isEmpty())
+      {
+        const Node& node = nodes[stack.pop()];
+
+        if (overlaps(node.bounds))
         {
-          refitChildren(node.parent, propagate);
+          if (bvh_node::isLeaf(node))
+          {
+            callback(node);
+          }
+          else
+          {
+            pushChildren(stack, node);
+          }
         }
+      }
+    }
 
-        return true;
+    struct BuildRef final
+    {
+      AABB          bounds;
+      float         centroid[3];
+      std::uint32_t leaf;
+    };
+
+    struct BuildTask final
+    {
+      NodeOffset    node;
+      NodeOffset    parent;
+      std::uint16_t depth;
+      std::size_t   ref_bgn;
+      std::size_t   ref_end;
+    };
+
+    struct BuildContext final
+    {
+      const BVHLeaf* leaves;
+      BuildRef*      refs;
+      NodeOffset*    out_leaf_nodes;
+      BuildTask*     tasks;
+      std::size_t    num_tasks;
+      std::size_t    split_size;
+    };
+
+    struct BuildBin final
+    {
+      AABB        bounds;
+      std::size_t count;
+    };
+
+    static AABB emptyBounds()
+    {
+      AABB result;  // NOLINT
+
+      for (int i = 0; i < 3; ++i)
+      {
+        result.min[i] = FLT_MAX;
+        result.max[i] = -FLT_MAX;
       }
 
-      return false;
+      return result;
     }
 
-    void updateDepth(BVHNodeOffset self, std::uint16_t depth)
+    static void growBounds(AABB& self, const AABB& bounds)
     {
-      BVHNode& node = nodeAt(self);
+      for (int i = 0; i < 3; ++i)
+      {
+        self.min[i] = std::min(self.min[i], bounds.min[i]);
+        self.max[i] = std::max(self.max[i], bounds.max[i]);
+      }
+    }
 
-      node.depth = depth;
+    void buildRange(BuildContext& ctx, NodeOffset node_idx, NodeOffset parent, std::uint16_t depth, std::size_t ref_bgn, std::size_t ref_end, bool can_defer)
+    {
+      const std::size_t num_refs = ref_end - ref_bgn;
 
-      if (depth > max_depth_)
+      if (can_defer && num_refs <= ctx.split_size)
       {
-        max_depth_ = depth;
+        ctx.tasks[ctx.num_tasks++] = {node_idx, parent, depth, ref_bgn, ref_end};
+        return;
       }
 
-      if (!bvh_node::isLeaf(node))
+      Node& node = nodes[node_idx];
+
+      node.parent = parent;
+      node.depth  = depth;
+
+      if (num_refs == 1)
       {
-        updateDepth(node.children[0], depth + 1);
-        updateDepth(node.children[1], depth + 1);
+        const BuildRef& ref = ctx.refs[ref_bgn];
+
+        node.user_data   = ctx.leaves[ref.leaf].user_data;
+        node.bounds      = ref.bounds;
+        node.children[0] = k_InvalidOffset;
+        node.children[1] = k_InvalidOffset;
+
+        ctx.out_leaf_nodes[ref.leaf] = node_idx;
+        return;
       }
+
+      const std::size_t ref_mid    = splitRange(ctx, node, ref_bgn, ref_end, depth < k_BVHMaxSAHDepth);
+      const NodeOffset  left_node  = NodeOffset(node_idx + 1);
+      const NodeOffset  right_node = NodeOffset(node_idx + (ref_mid - ref_bgn) * 2);
+
+      node.user_data   = nullptr;
+      node.children[0] = left_node;
+      node.children[1] = right_node;
+
+      buildRange(ctx, left_node, node_idx, std::uint16_t(depth + 1), ref_bgn, ref_mid, can_defer);
+      buildRange(ctx, right_node, node_idx, std::uint16_t(depth + 1), ref_mid, ref_end, can_defer);
     }
 
-    static void resetNode(BVHNode& node, void* user_data, const AABB& bounds)
+    // Calculates the bounds of `node` and returns where to split [ref_bgn, ref_end).
+    static std::size_t splitRange(BuildContext& ctx, Node& node, std::size_t ref_bgn, std::size_t ref_end, bool use_sah)
+    {
+      BuildRef* const   refs           = ctx.refs;
+      const std::size_t num_refs       = ref_end - ref_bgn;
+      AABB              bounds         = emptyBounds();
+      AABB              centroid_range = emptyBounds();
+
+      for (std::size_t i = ref_bgn; i < ref_end; ++i)
+      {
+        growBounds(bounds, refs[i].bounds);
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          centroid_range.min[axis] = std::min(centroid_range.min[axis], refs[i].centroid[axis]);
+          centroid_range.max[axis] = std::max(centroid_range.max[axis], refs[i].centroid[axis]);
+        }
+      }
+
+      node.bounds = bounds;
+
+      int axis = 0;
+
+      for (int i = 1; i < 3; ++i)
+      {
+        if ((centroid_range.max[i] - centroid_range.min[i]) > (centroid_range.max[axis] - centroid_range.min[axis]))
+        {
+          axis = i;
+        }
+      }
+
+      const float axis_min    = centroid_range.min[axis];
+      const float axis_extent = centroid_range.max[axis] - axis_min;
+
+      if (use_sah && axis_extent > 0.0f)
+      {
+        // NOTE(SR):
+        //   The scale is shrunk slightly so that the ref with the max centroid
+        //   lands in the last bin rather than one past it.
+
+        const float bin_scale = (float(k_BVHNumSAHBins) / axis_extent) * (1.0f - 1e-5f);
+        const auto  bin_index = [axis, axis_min, bin_scale](const BuildRef& ref) -> int {
+          return std::min(int((ref.centroid[axis] - axis_min) * bin_scale), k_BVHNumSAHBins - 1);
+        };
+
+        BuildBin bins[k_BVHNumSAHBins];
+
+        for (BuildBin& bin : bins)
+        {
+          bin.bounds = emptyBounds();
+          bin.count  = 0;
+        }
+
+        for (std::size_t i = ref_bgn; i < ref_end; ++i)
+        {
+          BuildBin& bin = bins[bin_index(refs[i])];
+
+          growBounds(bin.bounds, refs[i].bounds);
+          ++bin.count;
+        }
+
+        // Sweep from the right to get the cost of everything right of each split.
+
+        float right_costs[k_BVHNumSAHBins - 1];
+        AABB  right_bounds = emptyBounds();
+        float right_count  = 0.0f;
+
+        for (int i = k_BVHNumSAHBins - 1; i > 0; --i)
+        {
+          if (bins[i].count)
+          {
+            growBounds(right_bounds, bins[i].bounds);
+            right_count += float(bins[i].count);
+          }
+
+          right_costs[i - 1] = right_count > 0.0f ? right_count * aabb::surfaceArea(right_bounds) : 0.0f;
+        }
+
+        AABB  left_bounds = emptyBounds();
+        float left_count  = 0.0f;
+        float best_cost   = FLT_MAX;
+        int   best_split  = -1;
+
+        for (int i = 0; i < k_BVHNumSAHBins - 1; ++i)
+        {
+          if (bins[i].count)
+          {
+            growBounds(left_bounds, bins[i].bounds);
+            left_count += float(bins[i].count);
+          }
+
+          if (left_count > 0.0f && left_count < float(num_refs))
+          {
+            const float cost = left_count * aabb::surfaceArea(left_bounds) + right_costs[i];
+
+            if (cost < best_cost)
+            {
+              best_cost  = cost;
+              best_split = i;
+            }
+          }
+        }
+
+        if (best_split >= 0)
+        {
+          BuildRef* const split = std::partition(
+           refs + ref_bgn,
+           refs + ref_end,
+           [&bin_index, best_split](const BuildRef& ref) -> bool {
+             return bin_index(ref) <= best_split;
+           });
+
+          return std::size_t(split - refs);
+        }
+      }
+
+      // All centroids are in the same spot, or the tree is already deep, so just split down the middle.
+
+      const std::size_t ref_mid = ref_bgn + num_refs / 2;
+
+      std::nth_element(
+       refs + ref_bgn,
+       refs + ref_mid,
+       refs + ref_end,
+       [axis](const BuildRef& lhs, const BuildRef& rhs) -> bool {
+         return lhs.centroid[axis] < rhs.centroid[axis];
+       });
+
+      return ref_mid;
+    }
+
+    struct CullPlanes final
+    {
+      float normal[k_bfPlaneIdx_Max][3];
+      float abs_normal[k_bfPlaneIdx_Max][3];
+      float d[k_bfPlaneIdx_Max];
+    };
+
+    void cullNodes(const CullPlanes& planes, BVHCullingState& state) const
+    {
+      struct StackEntry final
+      {
+        NodeOffset   node;
+        std::uint8_t plane_mask;  // The planes the parent was not completely inside of, zero once fully inside the frustum.
+      };
+
+      BVHTraversalStack<StackEntry> stack{nodes.memory()};
+
+      stack.push({root_idx, k_BVHAllPlanesMask});
+
+      while (!stack.isEmpty())
+      {
+        StackEntry entry = stack.pop();
+
+        // Descends down the left side directly, only the right children go through the stack.
+        while (true)
+        {
+          const Node& node = nodes[entry.node];
+
+          if (entry.plane_mask && bvh_node::isLeaf(node))
+          {
+            state.leaf_batch.push(std::uint32_t(entry.node));
+            break;
+          }
+
+          if (entry.plane_mask && isCulled(node.bounds, planes, state.last_culled_plane[entry.node], entry.plane_mask))
+          {
+            break;
+          }
+
+          state.markVisible(entry.node);
+
+          if (bvh_node::isLeaf(node))
+          {
+            break;
+          }
+
+          bvh_node::prefetch(&nodes[node.children[1]]);
+          stack.push({node.children[1], entry.plane_mask});
+          entry.node = node.children[0];
+        }
+      }
+    }
+
+    void cullLeafBatch(const bfFrustum& frustum, BVHCullingState& state) const
+    {
+      const std::size_t num_leaves = state.leaf_batch.size();
+
+      if (!num_leaves)
+      {
+        return;
+      }
+
+      state.leaf_batch_bounds.resize(num_leaves * 6);
+      state.leaf_batch_visible.resize((num_leaves + 31) / 32);
+
+      float* const    bounds = state.leaf_batch_bounds.data();
+      const bfAABBSoA aabbs  = {
+       bounds + num_leaves * 0,
+       bounds + num_leaves * 1,
+       bounds + num_leaves * 2,
+       bounds + num_leaves * 3,
+       bounds + num_leaves * 4,
+       bounds + num_leaves * 5,
+       num_leaves,
+      };
+
+      for (std::size_t i = 0; i < num_leaves; ++i)
+      {
+        const AABB& leaf_bounds = nodes[state.leaf_batch[i]].bounds;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          bounds[num_leaves * axis + i]       = leaf_bounds.min[axis];
+          bounds[num_leaves * (axis + 3) + i] = leaf_bounds.max[axis];
+        }
+      }
+
+      bfFrustum_cullAABBs(&frustum, &aabbs, state.leaf_batch_visible.data());
+
+      for (std::size_t i = 0; i < num_leaves; ++i)
+      {
+        if (state.leaf_batch_visible[i >> 5] & (1u << (i & 31u)))
+        {
+          state.markVisible(state.leaf_batch[i]);
+        }
+      }
+    }
+
+    // Clears the bits from `plane_mask` of the planes `bounds` is completely inside of.
+    static bool isCulled(const AABB& bounds, const CullPlanes& planes, std::uint8_t& culled_plane, std::uint8_t& plane_mask)
+    {
+      float center[3];
+      float extents[3];
+
+      for (int i = 0; i < 3; ++i)
+      {
+        center[i]  = (bounds.max[i] + bounds.min[i]) * 0.5f;
+        extents[i] = (bounds.max[i] - bounds.min[i]) * 0.5f;
+      }
+
+      // NOTE(SR):
+      //   Starts at the plane that culled this node last time, objects
+      //   that were culled last frame most likely still are.
+
+      int plane_idx = culled_plane;
+
+      for (int i = 0; i < k_bfPlaneIdx_Max; ++i)
+      {
+        const std::uint8_t plane_bit = std::uint8_t(1u << plane_idx);
+
+        if (plane_mask & plane_bit)
+        {
+          const float* const n        = planes.normal[plane_idx];
+          const float* const abs_n    = planes.abs_normal[plane_idx];
+          const float        distance = n[0] * center[0] + n[1] * center[1] + n[2] * center[2] - planes.d[plane_idx];
+          const float        radius   = abs_n[0] * extents[0] + abs_n[1] * extents[1] + abs_n[2] * extents[2];
+
+          if (distance + radius < 0.0f)
+          {
+            culled_plane = std::uint8_t(plane_idx);
+            return true;
+          }
+
+          // Completely inside this plane so children do not need to test against it.
+          if (distance - radius >= 0.0f)
+          {
+            plane_mask &= ~plane_bit;
+          }
+        }
+
+        if (++plane_idx == k_bfPlaneIdx_Max)
+        {
+          plane_idx = 0;
+        }
+      }
+
+      return false;
+    }
+
+    // Children are pushed in reverse so that the left child is visited first, same order as a recursive traversal.
+    template<typename TStack>
+    void pushChildren(TStack& stack, const Node& node) const
+    {
+      bvh_node::prefetch(&nodes[node.children[0]]);
+      bvh_node::prefetch(&nodes[node.children[1]]);
+
+      stack.push(node.children[1]);
+      stack.push(node.children[0]);
+    }
+
+    void addNodeToRefit(NodeOffset node)
+    {
+      nodes_to_optimize.push(node);
+    }
+
+    void adoptNode(NodeOffset self, NodeOffset child, int index)
+    {
+      nodes[self].children[index] = child;
+      nodes[child].parent         = self;
+    }
+
+    bool refitChildren(NodeOffset self, bool propagate)
+    {
+      bool did_change = false;
+
+      // Walks up the parent chain rather than recursing, stops at the first node whose bounds did not change.
+      while (true)
+      {
+        Node& node = nodeAt(self);
+
+        assert(!bvh_node::isLeaf(node) && "Only nodes with children can be passed to this function.");
+
+        const AABB new_bounds = aabb::mergeBounds(nodes[node.children[0]].bounds, nodes[node.children[1]].bounds);
+
+        if (node.bounds == new_bounds)
+        {
+          break;
+        }
+
+        node.bounds = new_bounds;
+        did_change  = true;
+
+        if (!propagate || bvh_node::isNull(node.parent))
+        {
+          break;
+        }
+
+        self = node.parent;
+      }
+
+      return did_change;
+    }
+
+    void updateDepth(NodeOffset self, std::uint16_t depth)
+    {
+      nodeAt(self).depth = depth;
+
+      // Parents are visited before their children so the parent's depth is always up to date.
+      traverseConditionally(self, [this, self](Node& node) -> bool {
+        if (nodeToIndex(node) != self)
+        {
+          node.depth = std::uint16_t(nodes[node.parent].depth + 1);
+        }
+
+        if (node.depth > max_depth_)
+        {
+          max_depth_ = node.depth;
+        }
+
+        return true;
+      });
+    }
+
+    static void resetNode(Node& node, void* user_data, const AABB& bounds)
     {
       node.bounds      = bounds;
       node.user_data   = user_data;
-      node.parent      = k_BVHNodeInvalidOffset;
-      node.children[0] = k_BVHNodeInvalidOffset;
-      node.children[1] = k_BVHNodeInvalidOffset;
-      node.is_visible  = false;
+      node.parent      = k_InvalidOffset;
+      node.children[0] = k_InvalidOffset;
+      node.children[1] = k_InvalidOffset;
     }
 
-    BVHNodeOffset createNode(void* user_data, const AABB& bounds)
+    NodeOffset createNode(void* user_data, const AABB& bounds)
     {
       if (!bvh_node::isNull(freelist))
       {
-        const BVHNodeOffset idx      = freelist;
-        BVHNode&            node     = nodes[idx];
-        const BVHNodeOffset idx_next = node.next;
+        const NodeOffset idx      = freelist;
+        Node&            node     = nodes[idx];
+        const NodeOffset idx_next = node.next;
 
         resetNode(node, user_data, bounds);
 
@@ -629,19 +1716,30 @@ namespace bf
         return idx;
       }
 
-      const BVHNodeOffset idx = BVHNodeOffset(nodes.size());
+      const NodeOffset idx = NodeOffset(nodes.size());
 
       resetNode(nodes.emplace(), user_data, bounds);
 
       return idx;
     }
 
-    void addToFreelist(BVHNodeOffset index)
+    void addToFreelist(NodeOffset index)
     {
       nodes[index].next = freelist;
       freelist          = index;
     }
   };
+
+#if BF_BVH_USE_16BIT_NODE_OFFSETS
+  using BVHNodeOffset = std::uint16_t;
+#else
+  using BVHNodeOffset = std::uint32_t;
+#endif
+
+  using BVHNode = BVHNodeT<BVHNodeOffset>;
+  using BVH     = BVHT<BVHNodeOffset>;
+
+  static constexpr BVHNodeOffset k_BVHNodeInvalidOffset = BVHNode::k_InvalidOffset;
 }  // namespace bf
 
 #endif /* BF_BVH_HPP */
@@ -17,12 +17,14 @@
 #include "bf/DenseMap.hpp"           // DenseMap<T>
 #include "bf/utility/bifrost_uuid.h" /* bfUUIDNumber */
 
-#include <cstddef> /* nullptr_t */
+#include <chrono>  /* nanoseconds */
+#include <cstddef> /* nullptr_t   */
 
 namespace bf
 {
   class Entity;
   class IMemoryManager;
+  class Scene;
   
   class EntityRef final
   {
@@ -66,14 +68,40 @@ namespace bf
   //
   namespace gc
   {
+    //
+    // Limits how much work a single `collect` does so that a large
+    // despawn wave is spread out over a few frames, zero means no limit.
+    //
+    struct CollectBudget final
+    {
+      std::size_t              max_entities = 0u;  //!< Max number of Entities freed.
+      std::chrono::nanoseconds max_time     = {};  //!< Only checked every few Entities so this may be slightly overshot.
+    };
+
+    struct CollectStats final
+    {
+      std::size_t              num_pending = 0u;  //!< Entities still waiting to be freed, either referenced or over budget.
+      std::size_t              num_freed   = 0u;  //!<
+      std::size_t              bytes_freed = 0u;  //!<
+      std::chrono::nanoseconds time_spent  = {};  //!<
+    };
+
     void    init(IMemoryManager& memory);
     bool    hasUUID(const bfUUIDNumber& id);
     void    registerEntity(Entity& object);
+    void    reserve(std::size_t num_entities);  // Makes room for `num_entities` more registered Entities.
     Entity* findEntity(const bfUUIDNumber& id);
     void    removeEntity(Entity& object);
     void    reviveEntity(Entity& object);  // TODO(SR): Editor only API
-    void    collect(IMemoryManager& entity_memory);
     void    quit();
+
+    CollectStats collect(IMemoryManager& entity_memory, const CollectBudget& budget = {});
+
+    //
+    // Frees every unreferenced pending Entity of `scene` ignoring any budget,
+    // must be called before `scene` is destroyed since freeing an Entity uses its Scene.
+    //
+    CollectStats collect(IMemoryManager& entity_memory, const Scene& scene);
   }  // namespace gc
 }  // namespace bf
 
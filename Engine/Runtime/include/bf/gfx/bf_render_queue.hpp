@@ -9,15 +9,20 @@
 #ifndef BF_RENDER_QUEUE_HPP
 #define BF_RENDER_QUEUE_HPP
 
-#include "bf/Array.hpp"            // Array<T>
-#include "bf/LinearAllocator.hpp"  // LinearAllocator
-#include "bf/MemoryUtils.h"        // bfMegabytes
-#include "bf/bf_gfx_api.h"         // Graphics
+#include "bf/Array.hpp"             // Array<T>
+#include "bf/IMemoryManager.hpp"    // IMemoryManager
+#include "bf/MemoryUtils.h"         // bfKilobytes
+#include "bf/bf_gfx_api.h"          // Graphics
+#include "bf/bf_non_copy_move.hpp"  // NonCopyMoveable<T>
 
 #include <cassert>      // assert
 #include <cstdint>      // uint64_t
+#include <cstring>      // memcpy
 #include <limits>       // numeric_limits
+#include <mutex>        // mutex
+#include <new>          // placement new
 #include <type_traits>  // is_unsigned_v
+#include <utility>      // forward
 
 namespace bf
 {
@@ -196,11 +201,13 @@ namespace bf
     }
 
     void bind(bfGfxCommandListHandle command_list, std::uint32_t index);
+    bool isSameAs(const DescSetBind& rhs) const;
   };
 
   enum class RenderCommandType
   {
     DrawIndexed,
+    DrawIndexedInstanced,
     DrawArrays,
     Group,
     SetScissorRect,
@@ -255,6 +262,29 @@ namespace bf
     std::uint32_t      num_indices                 = 0u;
     std::uint64_t      index_buffer_binding_offset = 0u;
     bfGfxIndexType     index_type                  = BF_INDEX_TYPE_UINT32;
+
+    // Set these for the draw to be merged with neighboring draws of the same mesh and material, see `RenderQueue::MERGE_INSTANCES`.
+
+    bfShaderProgramHandle instanced_program = nullptr;  //!< Used in place of `pipeline.program`, reads its object data per instance.
+    const void*           instance_data     = nullptr;  //!< `IRenderInstanceBuffer::instanceDataSize` bytes, copied to the instance buffer when merged.
+  };
+
+  DECLARE_RENDER_CMD(DrawIndexedInstanced)
+  {
+    bfDrawCallPipeline pipeline                    = {};
+    DescSetBind        material_binding            = {};
+    DescSetBind        object_binding              = {};
+    std::uint32_t      num_vertex_buffers          = 0u;
+    bfBufferHandle*    vertex_buffers              = nullptr;
+    bfBufferSize*      vertex_binding_offsets      = nullptr;
+    bfBufferHandle     index_buffer                = nullptr;
+    std::uint32_t      vertex_offset               = 0u;
+    std::uint32_t      index_offset                = 0u;
+    std::uint32_t      num_indices                 = 0u;
+    std::uint64_t      index_buffer_binding_offset = 0u;
+    bfGfxIndexType     index_type                  = BF_INDEX_TYPE_UINT32;
+    std::uint32_t      first_instance              = 0u;
+    std::uint32_t      num_instances               = 0u;
   };
 
   // This is just a helper command type for storing other commands.
@@ -296,29 +326,111 @@ namespace bf
 
   struct RenderView;
 
-  struct RenderQueue
+  //
+  // GPU memory for per instance data of merged draws.
+  //
+
+  struct RenderInstanceRange
+  {
+    void*         data;            //!< Where the instance data should be written.
+    std::uint32_t first_instance;  //!< Index of the first instance within the buffer bound by `object_binding`.
+    DescSetBind   object_binding;
+  };
+
+  struct IRenderInstanceBuffer
+  {
+    virtual std::size_t         instanceDataSize() const    = 0;
+    virtual std::uint32_t       maxInstancesPerDraw() const = 0;
+    virtual RenderInstanceRange requestInstances(std::uint32_t num_instances) = 0;
+
+    virtual ~IRenderInstanceBuffer() = default;
+  };
+
+  //
+  // Command memory is handed out in pages that are linked together,
+  // all of the queues share a single pool so that a view only holds
+  // onto as many pages as it actually used this frame.
+  //
+
+  struct RenderCommandPage
+  {
+    RenderCommandPage* next;
+    std::size_t        capacity;  //!< Number of bytes available after this header.
+    std::size_t        used;
+
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+  };
+
+  struct RenderCommandPagePool : private NonCopyMoveable<RenderCommandPagePool>
+  {
+    static constexpr std::size_t k_PageSize = bfKilobytes(64);
+
+    IMemoryManager&    memory;
+    RenderCommandPage* free_list;
+    std::mutex         free_list_lock;  //!< Sub streams may be recorded from multiple threads.
+
+    explicit RenderCommandPagePool(IMemoryManager& memory);
+
+    // Will allocate a dedicated page if `min_capacity` does not fit in a `k_PageSize` page.
+    RenderCommandPage* acquire(std::size_t min_capacity);
+
+    // Returns the pages [head, tail] (linked by `RenderCommandPage::next`) back to the pool in O(1).
+    void release(RenderCommandPage* head, RenderCommandPage* tail);
+
+    ~RenderCommandPagePool();
+  };
+
+  struct RenderCommandStream : private NonCopyMoveable<RenderCommandStream>
   {
-    static constexpr std::size_t k_MaxDrawCalls      = 4096;
-    static constexpr std::size_t k_KeyBufferSize     = bfBytes((sizeof(RenderSortKey) * 2 + sizeof(std::uint64_t)) * k_MaxDrawCalls);
-    static constexpr std::size_t k_CommandBufferSize = bfMegabytes(5);
+    RenderCommandPagePool& pool;
+    RenderCommandPage*     head;
+    RenderCommandPage*     tail;
 
+    explicit RenderCommandStream(RenderCommandPagePool& pool);
+
+    void* allocate(std::size_t size, std::size_t alignment);
+
+    template<typename T, typename... Args>
+    T* allocateT(Args&&... args)
+    {
+      return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    T* allocateArrayTrivial(std::size_t num_items)
+    {
+      static_assert(std::is_trivially_constructible_v<T> && std::is_trivially_destructible_v<T>, "The command stream does not call constructors or destructors of array elements.");
+
+      return static_cast<T*>(allocate(sizeof(T) * num_items, alignof(T)));
+    }
+
+    void clear();
+
+    ~RenderCommandStream();
+  };
+
+  //
+  // Records commands and their sort keys.
+  // A single recorder must only be written to by one thread at a time.
+  //
+
+  struct RenderCommandRecorder : private NonCopyMoveable<RenderCommandRecorder>
+  {
     enum
     {
-      SORT_COMMANDS  = bfBit(0),  //!< Sorting can be disabled, useful for 2D graphics.
-      SORT_DEPTH_FTB = bfBit(1),  //!< Front to back works well for opaque objects.
+      SORT_COMMANDS    = bfBit(0),  //!< Sorting can be disabled, useful for 2D graphics.
+      SORT_DEPTH_FTB   = bfBit(1),  //!< Front to back works well for opaque objects.
+      SORT_RADIX_BYTES = bfBit(2),  //!< Sorts on 8bit digits rather than base 10, at most 8 passes over the keys.
+      MERGE_INSTANCES  = bfBit(3),  //!< After sorting, neighboring `RC_DrawIndexed` that allow it are merged into `RC_DrawIndexedInstanced`.
     };
 
-    FixedLinearAllocator<k_KeyBufferSize>     key_stream_memory;
-    FixedLinearAllocator<k_CommandBufferSize> command_stream_memory;
-    std::size_t                               num_keys;
-    std::uint8_t                              feature_flags;
+    Array<RenderSortKey> keys;
+    RenderCommandStream  command_stream;
+    std::uint8_t         feature_flags;
 
-    RenderQueue(std::uint8_t features = 0x0);
-
-    // Render Queue Owner API //
+    RenderCommandRecorder(RenderCommandPagePool& command_memory, std::uint8_t features);
 
     void clear();
-    void execute(bfGfxCommandListHandle command_list, const bfDescriptorSetInfo& camera_desc_set);
 
     // Making Commands //
 
@@ -327,6 +439,8 @@ namespace bf
     RC_DrawArrays*     drawArrays(const bfDrawCallPipeline& pipeline, std::uint32_t num_vertex_buffers);
     RC_DrawIndexed*    drawIndexed(const bfDrawCallPipeline& pipeline, std::uint32_t num_vertex_buffers, bfBufferHandle index_buffer);
 
+    RC_DrawIndexedInstanced* drawIndexedInstanced(const bfDrawCallPipeline& pipeline, std::uint32_t num_vertex_buffers, bfBufferHandle index_buffer);
+
     // Making Keys //
 
     std::uint64_t makeKeyFor(RC_DrawIndexed* command, float distance_to_camera) const;
@@ -339,20 +453,53 @@ namespace bf
     void submit(std::uint64_t key, BaseRenderCommand* command);
 
    private:
-    RenderSortKey* firstKey() const { return reinterpret_cast<RenderSortKey*>(key_stream_memory.begin()); }
-
     template<typename T, typename... Args>
     T* pushAlloc(Args&&... args)
     {
-      return command_stream_memory.allocateT<T>(std::forward<Args>(args)...);
+      return command_stream.allocateT<T>(std::forward<Args>(args)...);
     }
 
     template<typename T>
     T* pushAllocArray(std::size_t num_items)
     {
-      return command_stream_memory.allocateArrayTrivial<T>(num_items);
+      return command_stream.allocateArrayTrivial<T>(num_items);
     }
   };
+
+  //
+  // Commands can either be recorded directly into the queue or,
+  // when recording from multiple jobs, into a sub stream per job.
+  //
+  // Sub streams are merged into the queue in index order before
+  // sorting so the result does not depend on thread scheduling.
+  //
+
+  struct RenderQueue : public RenderCommandRecorder
+  {
+    Array<RenderSortKey>          sort_scratch;  //!< Kept around between frames so that sorting does not allocate in the steady state.
+    Array<RenderCommandRecorder*> sub_streams;   //!< Lazily created, kept around between frames.
+
+    RenderQueue(RenderCommandPagePool& command_memory, std::uint8_t features = 0x0);
+
+    // Render Queue Owner API //
+
+    void clear();
+
+    // `instance_buffer` is required for `MERGE_INSTANCES`, otherwise it may be nullptr.
+    void execute(bfGfxCommandListHandle command_list, const bfDescriptorSetInfo& camera_desc_set, IRenderInstanceBuffer* instance_buffer = nullptr);
+
+    // Parallel Recording //
+
+    // Must be called before any jobs record into the sub streams, this is not thread safe.
+    void                   prepareSubStreams(std::size_t num_streams);
+    RenderCommandRecorder& subStream(std::size_t index) { return *sub_streams[index]; }
+
+    ~RenderQueue();
+
+   private:
+    void mergeSubStreams();
+    void mergeInstances(RenderSortKey* keys_bgn, std::size_t num_keys, IRenderInstanceBuffer& instance_buffer);
+  };
 }  // namespace bf
 
 #endif /* BF_RENDER_QUEUE_HPP */
@@ -77,15 +77,16 @@ namespace bf
 
     void pushSprite(const Renderable2DPrimitive& sprite) const;
 
-    //
+    // Safe to call from multiple jobs as long as each uses its own `render_queue`.
+    // Returns the number of draw commands submitted.
 
-    static void pushModel(
+    static int pushModel(
      RenderView&               camera,
      Entity*                   entity,
      const ModelAsset&         model,
      const bfDrawCallPipeline& pipeline,
      StandardRenderer&         engine_renderer,
-     RenderQueue&              render_queue,
+     RenderCommandRecorder&    render_queue,
      float                     distance_from_camera = 1.0f);
   };
 }  // namespace bf
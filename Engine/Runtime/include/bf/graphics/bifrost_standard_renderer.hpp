@@ -24,8 +24,11 @@
 #include "bf/bifrost_math.hpp"                           /* Vec3f, Vec2f, bfColor4u */
 #include "bf/data_structures/bifrost_array.hpp"          /* Array<T>                */
 #include "bf/data_structures/bifrost_intrusive_list.hpp" /* List<T>                 */
+#include "bf/gfx/bf_render_queue.hpp"                    /* IRenderInstanceBuffer   */
 #include "bifrost_glsl_compiler.hpp"                     /* GLSLCompiler            */
 
+#include <mutex> /* mutex */
+
 namespace bf
 {
   //
@@ -46,6 +49,7 @@ namespace bf
   static constexpr int         k_GfxMaxLightsOnScreen            = k_GfxMaxPunctualLightsOnScreen + k_GfxMaxDirectionalLightsOnScreen;
   static constexpr std::size_t k_GfxMaxVertexBones               = 4;
   static constexpr std::size_t k_GfxMaxTotalBones                = 128;
+  static constexpr int         k_GfxMaxInstancesPerDraw          = 64;  /* Matches the constant defined in "assets/shaders/standard/object_instanced.ubo.glsl"                         */
 
   //
   // Forward Declarations
@@ -352,7 +356,7 @@ namespace bf
     // Pointer and offset is returned.
     std::pair<T*, int> requestVertices(const bfGfxFrameInfo& frame_info, int vertices)
     {
-      assert(vertices < NumVerticesPerBatch && "Could not handle this amount of vetices in one batch.");
+      assert(vertices <= NumVerticesPerBatch && "Could not handle this amount of vetices in one batch.");
 
       if (used_buffers.isEmpty() || used_buffers.back()->vertices_left < vertices)
       {
@@ -432,6 +436,37 @@ namespace bf
     }
   };
 
+  //
+  // Per instance object data for draws merged by `RenderQueue::MERGE_INSTANCES`.
+  //
+  class GfxInstanceBuffer final : public IRenderInstanceBuffer
+  {
+    using LinkedBuffer = GfxLinkedBuffer<ObjectUniformData, k_GfxMaxInstancesPerDraw, BF_BUFFER_USAGE_UNIFORM_BUFFER>;
+
+    // NOTE(SR):
+    //   The whole link is bound as the uniform buffer and the draw selects
+    //   its instances with `first_instance` so the link's frame offsets
+    //   must satisfy the uniform offset alignment of any device.
+    static_assert(sizeof(LinkedBuffer::TArray) % 256 == 0, "A link must be a multiple of the largest 'uniform_buffer_offset_alignment'.");
+    static_assert(sizeof(LinkedBuffer::TArray) <= 16384, "A link must fit within the minimum guaranteed uniform buffer range.");
+
+   private:
+    LinkedBuffer   m_Buffer;
+    bfGfxFrameInfo m_FrameInfo;
+
+   public:
+    explicit GfxInstanceBuffer(IMemoryManager& memory);
+
+    void init(bfGfxDeviceHandle device);
+    void frameBegin(const bfGfxFrameInfo& frame_info);
+    void flush();
+    void deinit();
+
+    std::size_t         instanceDataSize() const override { return sizeof(ObjectUniformData); }
+    std::uint32_t       maxInstancesPerDraw() const override { return k_GfxMaxInstancesPerDraw; }
+    RenderInstanceRange requestInstances(std::uint32_t num_instances) override;
+  };
+
   //
   // Main Renderer
   //
@@ -502,12 +537,15 @@ namespace bf
     bfShaderProgramHandle                    m_GBufferShader;
     bfShaderProgramHandle                    m_GBufferSelectionShader;
     bfShaderProgramHandle                    m_GBufferSkinnedShader;
+    bfShaderProgramHandle                    m_GBufferInstancedShader;
     bfShaderProgramHandle                    m_SSAOBufferShader;
     bfShaderProgramHandle                    m_SSAOBlurShader;
     bfShaderProgramHandle                    m_AmbientLighting;
     bfShaderProgramHandle                    m_LightShaders[LightShaders::MAX];
     List<Renderable<ObjectUniformData>>      m_RenderablePool;
     RenderableMapping                        m_RenderableMapping;  // TODO: Make this per Scene.
+    std::mutex                               m_RenderableMappingLock;  //!< Draw commands may be recorded from multiple jobs.
+    GfxInstanceBuffer                        m_InstanceBuffer;
     Array<bfGfxBaseHandle>                   m_AutoRelease;
     bfTextureHandle                          m_WhiteTexture;
     bfTextureHandle                          m_DefaultMaterialTexture;
@@ -534,13 +572,18 @@ namespace bf
     void               beginLightingPass(CameraGPUData& camera);
     void               beginScreenPass(bfGfxCommandListHandle command_list) const;
     void               endPass() const;
-    void               drawEnd() const;
+    void               drawEnd();
     void               frameEnd() const;
     void               deinit();
 
     bfDescriptorSetInfo makeMaterialInfo(const MaterialAsset& material);
     bfDescriptorSetInfo makeObjectTransformInfo(const Mat4x4& view_proj_cache, const CameraGPUData& camera, Entity& entity);
 
+    static ObjectUniformData makeObjectUniformData(const Mat4x4& view_proj_cache, Entity& entity);
+
+    // Returns nullptr if `program` has no variant that reads its object data per instance.
+    bfShaderProgramHandle instancedProgramFor(bfShaderProgramHandle program) const;
+
     void renderCameraTo(RenderView& view);
 
    private:
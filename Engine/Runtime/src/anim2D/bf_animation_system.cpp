@@ -3,14 +3,49 @@
 #include "bf/asset_io/bf_path_manip.hpp"
 #include "bf/asset_io/bf_spritesheet_asset.hpp"
 #include "bf/asset_io/bf_document.hpp"
+#include "bf/core/bf_parallel_for.hpp"  // parallelForChunks, parallelForEach
 #include "bf/ecs/bf_entity.hpp"
 
 #include "bf/core/bifrost_engine.hpp"
 
+#include <limits>  // numeric_limits
+
 namespace bf
 {
   static const bfTextureSamplerProperties k_SamplerNearestRepeat = bfTextureSamplerProperties_init(BF_SFM_NEAREST, BF_SAM_REPEAT);
 
+  // Minimum number of animated sprites stepped by a single job.
+  static constexpr std::size_t k_SpriteAnimationGrainSize = 256;
+
+  // Number of sprites handed to `bfAnim2D_stepFrame` at once, kept small enough for the stack.
+  static constexpr std::uint16_t k_SpriteAnimationBatchSize = 128;
+
+  // Minimum number of skeletons posed by a single job, a skeleton is a lot more work than a sprite.
+  static constexpr std::size_t k_SkeletonPoseGrainSize = 4;
+
+  struct SkeletonLOD final
+  {
+    float        max_distance;     //!< Furthest a skeleton can be from the closest camera to use this LOD.
+    std::uint8_t update_interval;  //!< Number of frames between full pose updates, the palettes are blended in between.
+    std::uint8_t max_bone_depth;   //!< Bones with more bone ancestors than this are left in their bind pose.
+  };
+
+  // NOTE(SR):
+  //   The last LOD is used for skeletons that no camera saw last frame, they are still updated every
+  //   so often rather than skipped since culling for this frame happens after animation is updated.
+
+  static constexpr SkeletonLOD k_SkeletonLODs[] = {
+   {10.0f, 1u, 0xFFu},
+   {25.0f, 2u, 0xFFu},
+   {50.0f, 3u, 8u},
+   {std::numeric_limits<float>::max(), 4u, 6u},
+   {std::numeric_limits<float>::max(), 8u, 3u},
+  };
+
+  static constexpr std::uint8_t k_CulledSkeletonLOD = std::uint8_t(bfCArraySize(k_SkeletonLODs) - 1u);
+
+  static_assert(bfCArraySize(k_SkeletonLODs) <= 8u, "SkeletonInstance::node_lod_masks only has a bit for 8 LODs.");
+
   void AnimationSystem::onInit(Engine& engine)
   {
     const bfAnim2DCreateParams create_anim_ctx = {nullptr, &engine};
@@ -21,6 +56,7 @@ namespace bf
   template<typename T, typename F>
   T lerpAtTime(const Anim3DAsset&           animation,
                const Anim3DAsset::Track<T>& track,
+               Anim3DAsset::KeyCursor&      cursor,
                AnimationTimeType            animation_time,
                T                            default_value,
                F&&                          lerp_fn)
@@ -37,7 +73,7 @@ namespace bf
       return track.keys[0].value;
     }
 
-    const std::size_t x_idx_curr = track.findKey(animation_time, animation.m_Memory);
+    const std::size_t x_idx_curr = track.findKey(animation_time, animation.m_Memory, cursor);
     const std::size_t x_idx_next = (x_idx_curr + 1) % num_keys;
 
     // assert(x_idx_next + 1 < num_keys);
@@ -58,12 +94,13 @@ namespace bf
   Vector3f vec3ValueAtTime(
    const Anim3DAsset&              animation,
    const Anim3DAsset::TripleTrack& track,
+   Anim3DAsset::TripleCursor&      cursor,
    AnimationTimeType               animation_time,
    float                           default_value)
   {
-    const float x = lerpAtTime<float>(animation, track.x, animation_time, default_value, &math::lerp<float, float>);
-    const float y = lerpAtTime<float>(animation, track.y, animation_time, default_value, &math::lerp<float, float>);
-    const float z = lerpAtTime<float>(animation, track.z, animation_time, default_value, &math::lerp<float, float>);
+    const float x = lerpAtTime<float>(animation, track.x, cursor.x, animation_time, default_value, &math::lerp<float, float>);
+    const float y = lerpAtTime<float>(animation, track.y, cursor.y, animation_time, default_value, &math::lerp<float, float>);
+    const float z = lerpAtTime<float>(animation, track.z, cursor.z, animation_time, default_value, &math::lerp<float, float>);
 
     //
     // The w = 0.0f for vectors   because the default value would be 1.0f and
@@ -75,11 +112,13 @@ namespace bf
   bfQuaternionf quatValueAtTime(
    const Anim3DAsset&                       animation,
    const Anim3DAsset::Track<bfQuaternionf>& track,
+   Anim3DAsset::KeyCursor&                  cursor,
    AnimationTimeType                        animation_time)
   {
     bfQuaternionf value = lerpAtTime<bfQuaternionf>(
      animation,
      track,
+     cursor,
      animation_time,
      bfQuaternionf_identity(),
      [](const bfQuaternionf& start, float factor, const bfQuaternionf& end) {
@@ -91,79 +130,202 @@ namespace bf
     return value;
   }
 
-  static void updateNodeAnimation(
-   const ModelAsset::Node*                      root_node,
-   const Anim3DAsset&                           animation,
-   AnimationTimeType                            animation_time,
-   const ModelAsset::Node*                      node,
-   const HashTable<std::uint8_t, std::uint8_t>& bone_to_channel,
-   const Matrix4x4f&                            global_inv_transform,
-   const ModelAsset::NodeIDBone*                input_transform,
-   Matrix4x4f*                                  output_transform,
-   const Matrix4x4f&                            parent_transform)
+  //
+  // Baked animations are read straight from their frames, otherwise
+  // each track is searched for the keys around `animation_time`.
+  //
+  static void sampleChannelPoses(
+   const Anim3DAsset&          animation,
+   AnimationTimeType           animation_time,
+   Anim3DAsset::ChannelCursor* key_cursors,
+   Anim3DAsset::ChannelPose*   out_poses)
   {
-    Matrix4x4f node_transform;  //  = node->transform;
+    if (animation.isBaked())
+    {
+      animation.samplePose(animation_time, out_poses);
+      return;
+    }
 
-    if (node->bone_idx != k_InvalidBoneID)
+    for (std::size_t channel_index = 0u; channel_index < animation.m_NumChannels; ++channel_index)
     {
-      const auto it = bone_to_channel.find(node->bone_idx);
+      const Anim3DAsset::Channel& channel = animation.m_Channels[channel_index];
+      Anim3DAsset::ChannelCursor& cursor  = key_cursors[channel_index];
+      Anim3DAsset::ChannelPose&   pose    = out_poses[channel_index];
 
-      if (it != bone_to_channel.end())
-      {
-        const std::uint8_t    channel_index = it->value();
-        Anim3DAsset::Channel& channel       = animation.m_Channels[channel_index];
-        const Vector3f        scale         = vec3ValueAtTime(animation, channel.scale, animation_time, 1.0f);
-        const bfQuaternionf   rotation      = quatValueAtTime(animation, channel.rotation, animation_time);
-        const Vector3f        translation   = vec3ValueAtTime(animation, channel.translation, animation_time, 0.0f);
+      pose.scale       = vec3ValueAtTime(animation, channel.scale, cursor.scale, animation_time, 1.0f);
+      pose.rotation    = quatValueAtTime(animation, channel.rotation, cursor.rotation, animation_time);
+      pose.translation = vec3ValueAtTime(animation, channel.translation, cursor.translation, animation_time, 0.0f);
+    }
+  }
 
-        Matrix4x4f scale_mat;
-        Matrix4x4f rotation_mat;
-        Matrix4x4f translation_mat;
+  //
+  // The channel each node is driven by depends on the {ModelAsset, Anim3DAsset} pair
+  // so it is only looked up by name when either of them changes rather than every frame.
+  //
+  static void bindSkeleton(SkeletonInstance& skeleton, const ModelAsset& model, const Anim3DAsset& animation)
+  {
+    const std::size_t num_nodes = model.m_Nodes.size();
+
+    skeleton.model     = &model;
+    skeleton.animation = &animation;
+    skeleton.key_cursors.clear();
+    skeleton.key_cursors.resize(animation.m_NumChannels);
+    skeleton.channel_poses.resize(animation.m_NumChannels);
+    skeleton.node_to_channel.resize(num_nodes);
+    skeleton.node_lod_masks.resize(num_nodes);
+    skeleton.node_transforms.resize(num_nodes);
+    skeleton.bone_palettes.resize(model.numBones() * 2u);
+    skeleton.update_interval     = 0u;
+    skeleton.frames_since_update = 0u;
+    skeleton.lod                 = k_CulledSkeletonLOD;
+
+    for (std::size_t node_idx = 0u; node_idx < num_nodes; ++node_idx)
+    {
+      const ModelAsset::Node& node          = model.m_Nodes[node_idx];
+      std::uint8_t            channel_index = k_InvalidBoneID;
+      std::uint32_t           bone_depth    = 0u;
+      std::uint8_t            lod_mask      = 0u;
 
-        Mat4x4_initScalef(&scale_mat, scale.x, scale.y, scale.z);
-        bfQuaternionf_toMatrix(rotation, &rotation_mat);
-        Mat4x4_initTranslatef(&translation_mat, translation.x, translation.y, translation.z);
+      for (std::uint32_t parent_idx = node.parent_idx; parent_idx != k_InvalidNodeIdx; parent_idx = model.m_Nodes[parent_idx].parent_idx)
+      {
+        bone_depth += model.m_Nodes[parent_idx].bone_idx != k_InvalidBoneID;
+      }
 
-        Mat4x4_mult(&rotation_mat, &scale_mat, &node_transform);
-        Mat4x4_mult(&translation_mat, &node_transform, &node_transform);
+      for (std::uint8_t lod = 0u; lod < bfCArraySize(k_SkeletonLODs); ++lod)
+      {
+        lod_mask |= std::uint8_t(bone_depth <= k_SkeletonLODs[lod].max_bone_depth) << lod;
       }
-      else  // Bone was not part of the animation
+
+      if (node.bone_idx != k_InvalidBoneID)
       {
-        node_transform = node->transform;
+        const auto it = animation.m_NameToChannel.find(node.name);
+
+        if (it != animation.m_NameToChannel.end())
+        {
+          channel_index = it->value();
+        }
       }
+
+      skeleton.node_to_channel[node_idx] = channel_index;
+      skeleton.node_lod_masks[node_idx]  = lod_mask;
     }
-    else
+  }
+
+  //
+  // Uses the distance to the closest camera that drew the skeleton last frame.
+  //
+  static std::uint8_t selectSkeletonLOD(Engine& engine, SkinnedMeshRenderer& mesh)
+  {
+    const Vec3f& position            = mesh.owner().transform().world_position;
+    float        closest_distance_sq = std::numeric_limits<float>::max();
+    bool         is_visible          = false;
+
+    engine.forEachCamera([&](const RenderView* camera) {
+      if (camera->bvh_culling.isVisible(mesh.m_BHVNode))
+      {
+        const Vec3f delta = bfV3f_sub(camera->cpu_camera.position, position);
+
+        closest_distance_sq = std::min(closest_distance_sq, Vec3f_lenSq(&delta));
+        is_visible          = true;
+      }
+    });
+
+    if (is_visible)
     {
-      node_transform = node->transform;
+      for (std::uint8_t lod = 0u; lod < k_CulledSkeletonLOD; ++lod)
+      {
+        if (closest_distance_sq <= k_SkeletonLODs[lod].max_distance * k_SkeletonLODs[lod].max_distance)
+        {
+          return lod;
+        }
+      }
     }
 
-    Matrix4x4f global_transform;
-    Mat4x4_mult(&parent_transform, &node_transform, &global_transform);
+    return k_CulledSkeletonLOD;
+  }
 
-    if (node->bone_idx != k_InvalidBoneID)
+  //
+  // A plain lerp of each matrix, the palettes are close enough together
+  // that the skew this introduces over a few frames is not noticeable.
+  //
+  static void blendBonePalettes(const Matrix4x4f* src_palette, const Matrix4x4f* dst_palette, std::size_t num_bones, float factor, Matrix4x4f* out_palette)
+  {
+    if (factor >= 1.0f)
     {
-      // out = global_inv_transform * global_transform * inv_bone
-      Matrix4x4f* const out = output_transform + node->bone_idx;
+      std::copy_n(dst_palette, num_bones, out_palette);
+      return;
+    }
 
-      Mat4x4_mult(&global_transform, &input_transform[node->bone_idx].transform, out);
-      Mat4x4_mult(&global_inv_transform, out, out);
+    for (std::size_t bone_idx = 0u; bone_idx < num_bones; ++bone_idx)
+    {
+      for (std::size_t i = 0u; i < bfCArraySize(out_palette[bone_idx].data); ++i)
+      {
+        out_palette[bone_idx].data[i] = math::lerp(src_palette[bone_idx].data[i], factor, dst_palette[bone_idx].data[i]);
+      }
     }
+  }
 
-    std::for_each_n(
-     root_node + node->first_child,
-     node->num_children,
-     [&](const ModelAsset::Node& child_node) -> void {
-       updateNodeAnimation(
-        root_node,
-        animation,
-        animation_time,
-        &child_node,
-        bone_to_channel,
-        global_inv_transform,
-        input_transform,
-        output_transform,
-        global_transform);
-     });
+  //
+  // Since parents always come before their children in `ModelAsset::m_Nodes`
+  // the parent's global transform is always ready by the time a child needs it.
+  //
+  static void updateSkeletonPose(
+   const ModelAsset&               model,
+   const std::uint8_t*             node_to_channel,
+   const std::uint8_t*             node_lod_masks,
+   std::uint8_t                    lod,
+   const Anim3DAsset::ChannelPose* channel_poses,
+   Matrix4x4f*                     node_transforms,
+   Matrix4x4f*                     output_bones)
+  {
+    const std::size_t num_nodes = model.m_Nodes.size();
+
+    for (std::size_t node_idx = 0u; node_idx < num_nodes; ++node_idx)
+    {
+      const ModelAsset::Node& node          = model.m_Nodes[node_idx];
+      const std::uint8_t      channel_index = node_to_channel[node_idx];
+      Matrix4x4f              local_transform;
+
+      if (channel_index != k_InvalidBoneID && (node_lod_masks[node_idx] & (1u << lod)))
+      {
+        const Anim3DAsset::ChannelPose& pose = channel_poses[channel_index];
+
+        Matrix4x4f scale_mat;
+        Matrix4x4f rotation_mat;
+        Matrix4x4f translation_mat;
+
+        Mat4x4_initScalef(&scale_mat, pose.scale.x, pose.scale.y, pose.scale.z);
+        bfQuaternionf_toMatrix(pose.rotation, &rotation_mat);
+        Mat4x4_initTranslatef(&translation_mat, pose.translation.x, pose.translation.y, pose.translation.z);
+
+        Mat4x4_mult(&rotation_mat, &scale_mat, &local_transform);
+        Mat4x4_mult(&translation_mat, &local_transform, &local_transform);
+      }
+      else  // Node was not part of the animation or is not animated at this LOD.
+      {
+        local_transform = node.transform;
+      }
+
+      Matrix4x4f& global_transform = node_transforms[node_idx];
+
+      if (node.parent_idx != k_InvalidNodeIdx)
+      {
+        Mat4x4_mult(&node_transforms[node.parent_idx], &local_transform, &global_transform);
+      }
+      else
+      {
+        global_transform = local_transform;
+      }
+
+      if (node.bone_idx != k_InvalidBoneID)
+      {
+        // out = global_inv_transform * global_transform * inv_bone
+        Matrix4x4f* const out = output_bones + node.bone_idx;
+
+        Mat4x4_mult(&global_transform, &model.m_BoneToModel[node.bone_idx].transform, out);
+        Mat4x4_mult(&model.m_GlobalInvTransform, out, out);
+      }
+    }
   }
 
   void AnimationSystem::onFrameUpdate(Engine& engine, float dt)
@@ -208,55 +370,91 @@ namespace bf
 
     if (scene)
     {
-      auto& engine_renderer = engine.renderer();
-      auto& anim_sprites    = scene->components<SpriteAnimator>();
-
-      struct BackPtrs
+      auto&             engine_renderer  = engine.renderer();
+      const auto        anim_sprites     = scene->query<SpriteAnimator, SpriteRenderer>();
+      const std::size_t num_anim_sprites = anim_sprites.size();
+
+      parallelForChunks(
+       num_anim_sprites,
+       parallelChunkCount(num_anim_sprites, k_SpriteAnimationGrainSize),
+       [&anim_sprites, dt](std::size_t, std::size_t idx_bgn, std::size_t idx_end) {
+         // NOTE(SR):
+         //   Each job steps its sprites in small batches so that
+         //   no shared scratch memory is needed between jobs.
+
+         bfAnim2DUpdateInfo   update_info[k_SpriteAnimationBatchSize];
+         SpriteAnimator*      animators[k_SpriteAnimationBatchSize];
+         SpriteRenderer*      renderers[k_SpriteAnimationBatchSize];
+         const bfSpritesheet* sheets[k_SpriteAnimationBatchSize];
+         std::uint16_t        num_sprites = 0u;
+
+         const auto flush_batch = [&]() {
+           bfAnim2D_stepFrame(update_info, sheets, num_sprites, dt);
+
+           for (std::uint16_t i = 0u; i < num_sprites; ++i)
+           {
+             const bfAnim2DUpdateInfo& result = update_info[i];
+             const bfSpritesheet*      sheet  = sheets[result.spritesheet_idx];
+             const bfUVRect            rect   = sheet->uvs[sheet->animations->frames[result.current_frame].frame_index];
+
+             renderers[i]->uvRect() = {rect.x, rect.y, rect.width, rect.height};
+
+             animators[i]->m_Anim2DUpdateInfo.time_left_for_frame = result.time_left_for_frame;
+             animators[i]->m_Anim2DUpdateInfo.current_frame       = result.current_frame;
+           }
+
+           num_sprites = 0u;
+         };
+
+         // Only entities with both an animator and a renderer can animate.
+         anim_sprites.forEachInRange(idx_bgn, idx_end, [&](SpriteAnimator& anim_sprite, SpriteRenderer& sprite) {
+           if (anim_sprite.m_Spritesheet && anim_sprite.m_Anim2DUpdateInfo.animation < anim_sprite.m_Spritesheet->spritesheet()->num_animations)
+           {
+             const auto current_idx = num_sprites++;
+
+             animators[current_idx]                   = &anim_sprite;
+             renderers[current_idx]                   = &sprite;
+             update_info[current_idx]                 = anim_sprite.m_Anim2DUpdateInfo;
+             update_info[current_idx].spritesheet_idx = current_idx;
+             sheets[current_idx]                      = anim_sprite.m_Spritesheet->spritesheet();
+
+             if (num_sprites == k_SpriteAnimationBatchSize)
+             {
+               flush_batch();
+             }
+           }
+         });
+
+         flush_batch();
+       });
+
+      // 3D Skeletons
+
+      struct SkeletonPoseJob final
       {
-        SpriteAnimator* animator;
-        SpriteRenderer* renderer;
+        SkeletonInstance*  skeleton;
+        const ModelAsset*  model;
+        const Anim3DAsset* animation;
+        AnimationTimeType  animation_time;  //!< The time of the next full update, only used when `do_pose` is set.
+        std::uint8_t       lod;             //!< Only used when `do_pose` is set.
+        bool               do_pose;
+        float              blend_factor;  //!< How far between the last and next palette this frame is.
+        Matrix4x4f*        output_bones;
       };
 
-      // TODO(SR): This should use a linear allocator memory scope.
-
-      bfAnim2DUpdateInfo*   update_info = engine.tempMemory().allocateArrayTrivial<bfAnim2DUpdateInfo>(anim_sprites.size());
-      BackPtrs*             back_ptrs   = engine.tempMemory().allocateArrayTrivial<BackPtrs>(anim_sprites.size());
-      const bfSpritesheet** sheets      = engine.tempMemory().allocateArrayTrivial<const bfSpritesheet*>(anim_sprites.size());
-      std::uint16_t         num_sprites = 0u;
-
-      for (auto& anim_sprite : anim_sprites)
-      {
-        SpriteRenderer* const sprite = anim_sprite.owner().get<SpriteRenderer>();
-
-        if (sprite && anim_sprite.m_Spritesheet && anim_sprite.m_Anim2DUpdateInfo.animation < anim_sprite.m_Spritesheet->spritesheet()->num_animations)
-        {
-          const auto current_idx = num_sprites++;
-
-          back_ptrs[current_idx].animator          = &anim_sprite;
-          back_ptrs[current_idx].renderer          = sprite;
-          update_info[current_idx]                 = anim_sprite.m_Anim2DUpdateInfo;
-          update_info[current_idx].spritesheet_idx = current_idx;
-          sheets[current_idx]                      = anim_sprite.m_Spritesheet->spritesheet();
-        }
-      }
-
-      bfAnim2D_stepFrame(update_info, sheets, num_sprites, dt);
-
-      for (std::uint16_t i = 0u; i < num_sprites; ++i)
-      {
-        SpriteRenderer* const     sprite = back_ptrs[i].renderer;
-        const bfAnim2DUpdateInfo& result = update_info[i];
-        const bfSpritesheet*      sheet  = sheets[result.spritesheet_idx];
-        const bfUVRect            rect   = sheet->uvs[sheet->animations->frames[result.current_frame].frame_index];
-
-        sprite->uvRect() = {rect.x, rect.y, rect.width, rect.height};
-
-        back_ptrs[i].animator->m_Anim2DUpdateInfo.time_left_for_frame = result.time_left_for_frame;
-        back_ptrs[i].animator->m_Anim2DUpdateInfo.current_frame       = result.current_frame;
-      }
+      // NOTE(SR):
+      //   Finding the SkeletonInstance and mapping its bone buffer are not thread safe so they are done
+      //   up front, after that each job only writes to the skeletons and bone buffers it was handed.
+      //
+      //   Skeletons that are not fully updated this frame still have their palette written
+      //   since each frame in flight has its own region of the bone buffer.
 
-      Matrix4x4f identity;
-      Mat4x4_identity(&identity);
+      auto&                  tmp_memory     = engine.tempMemory();
+      LinearAllocatorScope   mem_scope      = {tmp_memory};
+      const std::size_t      max_skeletons  = scene->componentStorage().count(k_ComponentMask<SkinnedMeshRenderer>);
+      SkeletonPoseJob* const skeleton_jobs  = tmp_memory.allocateArrayTrivial<SkeletonPoseJob>(max_skeletons);
+      std::size_t            num_skeletons  = 0u;
+      const bfBufferSize     bone_data_size = sizeof(ObjectBoneData);
 
       for (auto& mesh : scene->components<SkinnedMeshRenderer>())
       {
@@ -265,78 +463,102 @@ namespace bf
 
         if (mesh.material() && model && animation_handle)
         {
-          auto* const             animation             = &*animation_handle;
-          const AnimationTimeType duration              = animation->m_Duration;
-          const AnimationTimeType current_time          = mesh.m_CurrentTime;
-          const AnimationTimeType current_time_in_ticks = current_time * animation->m_TicksPerSecond;
-          const AnimationTimeType animation_time        = std::fmod(current_time_in_ticks, duration);
+          auto* const             animation    = &*animation_handle;
+          const AnimationTimeType duration     = animation->m_Duration;
+          const AnimationTimeType current_time = mesh.m_CurrentTime;
 
           mesh.m_CurrentTime += double(dt);
 
-          //
-          // TODO(SR): This can be baked once \/\/\/\/\/
-          //
-
-          //
-          // NOTE(SR): This data must be backed per {ModelAsset, Anim3DAsset} pair.
-          //
-
-          //
-          // If this was backed once then in the main loop no string lookups are needed.
-          //
+          SkeletonInstance& skeleton = getSkeleton(engine_renderer, mesh.owner());
 
-          // TODO(SR): Maybe this can be an array rather than a map.
-          HashTable<std::uint8_t, std::uint8_t> bone_to_channel = {};
-
-          std::uint8_t bone_index = 0u;
-          for (const auto& bones : model->m_BoneToModel)
+          // NOTE(SR): The sizes are checked too since either asset could have been reloaded in place.
+          if (skeleton.model != &*model || skeleton.animation != animation ||
+              skeleton.node_to_channel.size() != model->m_Nodes.size() ||
+              skeleton.channel_poses.size() != animation->m_NumChannels)
           {
-            const ModelAsset::Node& node = model->m_Nodes[bones.node_idx];
-            const auto              it   = animation->m_NameToChannel.find(node.name);
+            bindSkeleton(skeleton, *model, *animation);
+          }
+
+          SkeletonPoseJob&   job             = skeleton_jobs[num_skeletons++];
+          const std::uint8_t lod             = selectSkeletonLOD(engine, mesh);
+          const bool         is_lod_improved = lod < skeleton.lod;
 
-            assert(node.bone_idx == bone_index);
+          // NOTE(SR):
+          //   A skeleton moving to a finer LOD (most often one coming back into view after
+          //   using `k_CulledSkeletonLOD`) is posed right away rather than finishing its old interval.
 
-            if (it != animation->m_NameToChannel.end())
-            {
-              bone_to_channel.insert(bone_index, it->value());
-            }
+          job.skeleton       = &skeleton;
+          job.model          = &*model;
+          job.animation      = animation;
+          job.animation_time = 0.0;
+          job.lod            = lod;
+          job.do_pose        = is_lod_improved || skeleton.frames_since_update >= skeleton.update_interval;
 
-            ++bone_index;
+          if (job.do_pose)
+          {
+            // The very first pose, and the first at a finer LOD, are shown right away instead of being blended towards.
+            const std::uint8_t      update_interval = skeleton.update_interval && !is_lod_improved ? k_SkeletonLODs[lod].update_interval : std::uint8_t(1u);
+            const AnimationTimeType pose_time       = current_time + double(dt) * AnimationTimeType(update_interval - 1u);
+
+            job.animation_time           = std::fmod(pose_time * animation->m_TicksPerSecond, duration);
+            skeleton.update_interval     = update_interval;
+            skeleton.frames_since_update = 0u;
+            skeleton.lod                 = lod;
           }
 
-          //
-          // TODO(SR): This can be baked once /\/\/\/\/\
-          //
+          job.blend_factor = float(skeleton.frames_since_update + 1u) / float(skeleton.update_interval);
+          ++skeleton.frames_since_update;
 
-          ModelAsset::Node&           root_node         = model->m_Nodes[0];
-          Renderable<ObjectBoneData>& uniform_bone_data = getRenderable(engine_renderer, mesh.owner());
+          Renderable<ObjectBoneData>& uniform_bone_data = skeleton.renderable;
           const bfBufferSize          offset            = uniform_bone_data.transform_uniform.offset(engine_renderer.frameInfo());
-          const bfBufferSize          size              = sizeof(ObjectBoneData);
-          ObjectBoneData* const       obj_data          = static_cast<ObjectBoneData*>(bfBuffer_map(uniform_bone_data.transform_uniform.handle(), offset, size));
-          Matrix4x4f*                 output_bones      = obj_data->u_Bones;
-
-          std::for_each_n(
-           output_bones,
-           model->m_BoneToModel.size(),
-           [](Matrix4x4f& mat) {
-             Mat4x4_identity(&mat);
-           });
-
-          updateNodeAnimation(
-           &root_node,
-           *animation,
-           animation_time,
-           &root_node,
-           bone_to_channel,
-           model->m_GlobalInvTransform,
-           model->m_BoneToModel.data(),
-           output_bones,
-           identity);
-
-          uniform_bone_data.transform_uniform.flushCurrent(engine_renderer.frameInfo(), size);
-          bfBuffer_unMap(uniform_bone_data.transform_uniform.handle());
+          ObjectBoneData* const       obj_data          = static_cast<ObjectBoneData*>(bfBuffer_map(uniform_bone_data.transform_uniform.handle(), offset, bone_data_size));
+
+          job.output_bones = obj_data->u_Bones;
         }
       }
+
+      parallelForEach(
+       skeleton_jobs,
+       num_skeletons,
+       [](const SkeletonPoseJob& job) {
+         SkeletonInstance& skeleton     = *job.skeleton;
+         const std::size_t num_bones    = job.model->numBones();
+         Matrix4x4f* const last_palette = skeleton.bone_palettes.data();
+         Matrix4x4f* const next_palette = last_palette + num_bones;
+
+         if (job.do_pose)
+         {
+           std::copy_n(next_palette, num_bones, last_palette);
+
+           sampleChannelPoses(*job.animation, job.animation_time, skeleton.key_cursors.data(), skeleton.channel_poses.data());
+
+           std::for_each_n(
+            next_palette,
+            num_bones,
+            [](Matrix4x4f& mat) {
+              Mat4x4_identity(&mat);
+            });
+
+           updateSkeletonPose(
+            *job.model,
+            skeleton.node_to_channel.data(),
+            skeleton.node_lod_masks.data(),
+            job.lod,
+            skeleton.channel_poses.data(),
+            skeleton.node_transforms.data(),
+            next_palette);
+         }
+
+         blendBonePalettes(last_palette, next_palette, num_bones, job.blend_factor, job.output_bones);
+       },
+       k_SkeletonPoseGrainSize);
+
+      std::for_each_n(skeleton_jobs, num_skeletons, [&engine_renderer, bone_data_size](const SkeletonPoseJob& job) {
+        Renderable<ObjectBoneData>& uniform_bone_data = job.skeleton->renderable;
+
+        uniform_bone_data.transform_uniform.flushCurrent(engine_renderer.frameInfo(), bone_data_size);
+        bfBuffer_unMap(uniform_bone_data.transform_uniform.handle());
+      });
     }
   }
 
@@ -344,31 +566,31 @@ namespace bf
   {
     bfAnim2D_delete(m_Anim2DCtx);
 
-    for (auto& r : m_RenderablePool)
+    for (auto& skeleton : m_SkeletonPool)
     {
-      r.destroy(engine.renderer().device());
+      skeleton.renderable.destroy(engine.renderer().device());
     }
-    m_RenderablePool.clear();
-    m_Renderables.clear();
+    m_SkeletonPool.clear();
+    m_Skeletons.clear();
   }
 
-  Renderable<ObjectBoneData>& AnimationSystem::getRenderable(StandardRenderer& renderer, Entity& entity)
+  SkeletonInstance& AnimationSystem::getSkeleton(StandardRenderer& renderer, Entity& entity)
   {
-    auto it = m_Renderables.find(&entity);
+    auto it = m_Skeletons.find(&entity);
 
-    Renderable<ObjectBoneData>* renderable;
+    SkeletonInstance* skeleton;
 
-    if (it == m_Renderables.end())
+    if (it == m_Skeletons.end())
     {
-      renderable = &m_RenderablePool.emplaceFront();
-      renderable->create(renderer.device(), renderer.frameInfo());
-      m_Renderables.emplace(&entity, renderable);
+      skeleton = &m_SkeletonPool.emplaceFront(m_SkeletonPool.memory());
+      skeleton->renderable.create(renderer.device(), renderer.frameInfo());
+      m_Skeletons.emplace(&entity, skeleton);
     }
     else
     {
-      renderable = it->value();
+      skeleton = it->value();
     }
 
-    return *renderable;
+    return *skeleton;
   }
 }  // namespace bf
@@ -17,6 +17,7 @@
 #include "bf/asset_io/bf_document.hpp"             /* BaseDocument             */
 #include "bf/asset_io/bifrost_file.hpp"            /* File                 */
 #include "bf/asset_io/bifrost_json_serializer.hpp" /* JsonSerializerReader */
+#include "bf/core/bf_parallel_for.hpp"             /* parallelForChunks    */
 #include "bf/core/bifrost_engine.hpp"              /* Engine               */
 #include "bf/ecs/bf_entity.hpp"                    /* Entity               */
 #include "bf/ecs/bifrost_collision_system.hpp"     /* DebugRenderer        */
@@ -29,12 +30,12 @@ namespace bf
     m_Engine{engine},
     m_Memory{m_Engine.mainMemory()},
     m_RootEntities{&Entity::m_Hierarchy},
-    m_ActiveComponents{m_Memory},
-    m_InactiveComponents{m_Memory},
+    m_Components{m_Memory},
     m_ActiveBehaviors{m_Memory},
     m_BVHTree{m_Memory},
     m_Camera{},
-    m_DirtyList{nullptr}
+    m_DirtyList{nullptr},
+    m_IsBulkLoading{false}
   {
     Camera_init(&m_Camera, nullptr, nullptr, 0.0f, 0.0f);
 
@@ -64,10 +65,13 @@ namespace bf
 
         m_RootEntities.clear();
 
-        for (std::size_t i = 0; i < num_entities; ++i)
-        {
-          addEntity(nullptr);
-        }
+        LinearAllocator&     temp_memory  = m_Engine.tempMemory();
+        LinearAllocatorScope memory_scope = {temp_memory};
+        Entity** const       entities     = temp_memory.allocateArrayTrivial<Entity*>(num_entities);
+
+        // Each loaded Entity registers the UUID it was saved with.
+        gc::reserve(num_entities);
+        addEntities(num_entities, entities, nullptr);
       }
       // else
       // {
@@ -92,6 +96,21 @@ namespace bf
     return m_Engine.createEntity(*this, name);
   }
 
+  std::size_t Scene::addEntities(std::size_t num_entities, Entity** out_entities, const StringRange& name)
+  {
+    // NOTE(SR):
+    //   Unlike `addEntity` no EntityRef is made so the Entities do not get a UUID
+    //   or a GC registration until something actually takes a reference to them.
+
+    const std::size_t num_added = m_Engine.entityStorage().allocateEntities(num_entities, *this, name, out_entities);
+
+    std::for_each_n(out_entities, num_added, [this](Entity* entity) {
+      m_RootEntities.pushBack(*entity);
+    });
+
+    return num_added;
+  }
+
   EntityRef Scene::findEntity(const StringRange& name) const
   {
     for (Entity& root_entity : m_RootEntities)
@@ -110,14 +129,38 @@ namespace bf
     m_RootEntities.erase(*entity);
   }
 
+  void Scene::destroyEntities(Entity* const* entities, std::size_t num_entities)
+  {
+    std::for_each_n(entities, num_entities, [](Entity* entity) {
+      entity->destroy();
+    });
+
+    dropDestroyedFromDirtyList();
+  }
+
   void Scene::removeAllEntities()
   {
+    // Dropping the dirty list up front saves each destroyed transform from searching it.
+    while (m_DirtyList)
+    {
+      bfTransform* const transform = std::exchange(m_DirtyList, m_DirtyList->dirty_list_next);
+
+      transform->dirty_list_next = nullptr;
+      transform->flags &= ~(BF_TRANSFORM_IN_DIRTY_LIST | BF_TRANSFORM_FLUSH_PENDING);
+    }
+
     while (!m_RootEntities.isEmpty())
     {
       m_RootEntities.back().destroy();
       // Entity::destroy detaches from parent.
       // m_RootEntities.pop();
     }
+
+    // NOTE(SR):
+    //   The end of frame collect is budgeted so these could otherwise
+    //   still be pending once this Scene has been unloaded or destroyed.
+
+    gc::collect(m_Engine.entityStorage(), *this);
   }
 
   void Scene::update(LinearAllocator& temp, DebugRenderer& dbg_renderer)
@@ -199,8 +242,10 @@ namespace bf
       {
         m_SceneAsset = addAsset<SceneAsset>(ResourceID{1u}, relativePath(), assets().engine());
 
+        m_SceneAsset->beginBulkLoad();
         m_SceneAsset->reflect(reader);
         reader.endDocument();
+        m_SceneAsset->endBulkLoad(temp_alloc);
 
         return AssetStatus::LOADED;
       }
@@ -255,41 +300,265 @@ namespace bf
     return world_space_bounds;
   }
 
-  void Scene::updateDirtyListTransforms()
+  void Scene::rebuildBVH(LinearAllocator& temp)
   {
-    if (m_DirtyList)
-    {
-      bfTransform* transform = m_DirtyList;
+    const auto           meshes         = components<MeshRenderer>();
+    const auto           skinned_meshes = components<SkinnedMeshRenderer>();
+    const auto           sprites        = components<SpriteRenderer>();
+    const std::size_t    num_leaves     = meshes.size() + skinned_meshes.size() + sprites.size();
+    LinearAllocatorScope mem_scope      = {temp};
+    BVHLeaf* const       leaves         = temp.allocateArrayTrivial<BVHLeaf>(num_leaves);
+    BVHNodeOffset* const leaf_nodes     = temp.allocateArrayTrivial<BVHNodeOffset>(num_leaves);
+    std::size_t          leaf_index     = 0;
+
+    const auto gather_leaves = [leaves, &leaf_index](auto& renderers) {
+      for (auto& renderer : renderers)
+      {
+        BVHLeaf& leaf = leaves[leaf_index++];
+
+        leaf.user_data = &renderer.owner();
+        leaf.bounds    = calcBounds(renderer, renderer.owner().transform());
+      }
+    };
 
-      while (transform)
+    const auto assign_leaves = [leaf_nodes, &leaf_index](auto& renderers) {
+      for (auto& renderer : renderers)
       {
-        bfTransform* const next_transform = std::exchange(transform->dirty_list_next, nullptr);
-        transform->flags &= ~BF_TRANSFORM_LOCAL_DIRTY;
+        renderer.m_BHVNode = leaf_nodes[leaf_index++];
+      }
+    };
 
-        Entity* const entity       = Entity::fromTransform(transform);
-        auto* const   mesh         = entity->get<MeshRenderer>();
-        auto* const   skinned_mesh = entity->get<SkinnedMeshRenderer>();
-        auto* const   sprite       = entity->get<SpriteRenderer>();
+    gather_leaves(meshes);
+    gather_leaves(skinned_meshes);
+    gather_leaves(sprites);
 
-        if (mesh)
-        {
-          m_BVHTree.markLeafDirty(mesh->m_BHVNode, calcBounds(*mesh, *transform));
-        }
+    m_BVHTree.buildFromLeaves(leaves, num_leaves, leaf_nodes, temp);
 
-        if (skinned_mesh)
-        {
-          m_BVHTree.markLeafDirty(skinned_mesh->m_BHVNode, calcBounds(*skinned_mesh, *transform));
-        }
+    leaf_index = 0;
+
+    assign_leaves(meshes);
+    assign_leaves(skinned_meshes);
+    assign_leaves(sprites);
+  }
+
+  void Scene::beginBulkLoad()
+  {
+    assert(!m_IsBulkLoading && "Bulk loads cannot be nested.");
+
+    m_IsBulkLoading = true;
+  }
+
+  void Scene::endBulkLoad(LinearAllocator& temp)
+  {
+    assert(m_IsBulkLoading && "Unmatched call to Scene::endBulkLoad.");
+
+    m_IsBulkLoading = false;
+    rebuildBVH(temp);
+  }
+
+  void Scene::flushTransforms()
+  {
+    // Minimum number of transforms a single job will flush.
+    static constexpr std::size_t k_TransformFlushGrainSize = 512;
+
+    struct PendingRoot final
+    {
+      bfTransform* transform;
+      std::size_t  first_index;  // Index of this subtree's first transform counting every pending subtree before it.
+    };
+
+    struct ChunkDirtyList final
+    {
+      bfTransform* head;
+      bfTransform* tail;
+    };
+
+    if (job::numWorkers() <= 1)
+    {
+      bfTransform_flushDirtyList(&m_DirtyList);
+      return;
+    }
+
+    bfTransform* const pending_roots = bfTransform_takePendingRoots(&m_DirtyList);
+
+    if (!pending_roots)
+    {
+      return;
+    }
+
+    // A single subtree can only be flushed by one job so skip sizing it.
+    if (!pending_roots->dirty_list_next)
+    {
+      bfTransform_flushSubtree(pending_roots, &m_DirtyList);
+      return;
+    }
 
-        if (sprite)
+    LinearAllocator&     temp_memory  = m_Engine.tempMemory();
+    LinearAllocatorScope memory_scope = {temp_memory};
+    std::size_t          num_roots    = 0;
+
+    for (bfTransform* root = pending_roots; root; root = root->dirty_list_next)
+    {
+      ++num_roots;
+    }
+
+    PendingRoot* const roots          = temp_memory.allocateArrayTrivial<PendingRoot>(num_roots);
+    std::size_t        num_transforms = 0;
+    std::size_t        root_index     = 0;
+
+    for (bfTransform* root = pending_roots; root;)
+    {
+      roots[root_index++] = {root, num_transforms};
+      num_transforms += bfTransform_subtreeSize(root);
+
+      root = std::exchange(root->dirty_list_next, nullptr);
+    }
+
+    // NOTE(SR):
+    //   The chunks split up the transforms rather than the roots so that a few large subtrees
+    //   do not all land in the same job, a chunk flushes each subtree that starts inside of it.
+    //
+    //   Each chunk builds its own dirty list, they are spliced together in chunk order which
+    //   gives the same list as flushing the subtrees one after another on a single thread.
+
+    const std::size_t     num_chunks  = parallelChunkCount(num_transforms, k_TransformFlushGrainSize);
+    ChunkDirtyList* const chunk_lists = temp_memory.allocateArrayTrivial<ChunkDirtyList>(num_chunks);
+
+    parallelForChunks(num_transforms, num_chunks, [roots, num_roots, chunk_lists](std::size_t chunk_index, std::size_t idx_bgn, std::size_t idx_end) {
+      ChunkDirtyList&    list  = chunk_lists[chunk_index];
+      const PendingRoot* root  = std::lower_bound(
+       roots,
+       roots + num_roots,
+       idx_bgn,
+       [](const PendingRoot& lhs, std::size_t index) -> bool {
+         return lhs.first_index < index;
+       });
+      const PendingRoot* const roots_end = roots + num_roots;
+
+      list = {nullptr, nullptr};
+
+      for (; root != roots_end && root->first_index < idx_end; ++root)
+      {
+        // The root is the first transform added to the list so it ends up at the back.
+        if (!list.tail)
         {
-          m_BVHTree.markLeafDirty(sprite->m_BHVNode, calcBounds(*sprite, *transform));
+          list.tail = root->transform;
         }
 
-        transform = next_transform;
+        bfTransform_flushSubtree(root->transform, &list.head);
+      }
+    });
+
+    for (std::size_t i = 0; i < num_chunks; ++i)
+    {
+      const ChunkDirtyList& list = chunk_lists[i];
+
+      if (list.head)
+      {
+        list.tail->dirty_list_next = m_DirtyList;
+        m_DirtyList                = list.head;
       }
+    }
+  }
+
+  void Scene::updateDirtyListTransforms()
+  {
+    // Minimum number of moved transforms a single job will recalculate the bounds of.
+    static constexpr std::size_t k_BoundsUpdateGrainSize = 256;
+
+    struct MovedLeaf final
+    {
+      BVHNodeOffset node;
+      AABB          bounds;
+    };
+
+    struct MovedTransform final
+    {
+      bfTransform*  transform;
+      std::uint32_t num_leaves;
+      MovedLeaf     leaves[3];  // One for each of MeshRenderer, SkinnedMeshRenderer and SpriteRenderer.
+    };
+
+    flushTransforms();
+
+    if (!m_DirtyList)
+    {
+      return;
+    }
+
+    LinearAllocator&     temp_memory  = m_Engine.tempMemory();
+    LinearAllocatorScope memory_scope = {temp_memory};
+    std::size_t          num_moved    = 0;
+
+    for (bfTransform* transform = m_DirtyList; transform; transform = transform->dirty_list_next)
+    {
+      ++num_moved;
+    }
+
+    MovedTransform* const moved       = temp_memory.allocateArrayTrivial<MovedTransform>(num_moved);
+    std::size_t           moved_index = 0;
+
+    for (bfTransform* transform = std::exchange(m_DirtyList, nullptr); transform;)
+    {
+      transform->flags &= ~(BF_TRANSFORM_LOCAL_DIRTY | BF_TRANSFORM_IN_DIRTY_LIST);
+
+      moved[moved_index++].transform = transform;
+
+      transform = std::exchange(transform->dirty_list_next, nullptr);
+    }
+
+    // NOTE(SR):
+    //   Calculating the bounds only reads from the components so it is split across jobs,
+    //   the BVH is not thread safe so the leaves are updated afterwards on this thread.
+
+    parallelForEach(
+     moved,
+     num_moved,
+     [](MovedTransform& item) {
+       Entity* const entity   = Entity::fromTransform(item.transform);
+       const auto    add_leaf = [&item](const auto* renderer) {
+         if (renderer)
+         {
+           item.leaves[item.num_leaves++] = {renderer->m_BHVNode, calcBounds(*renderer, *item.transform)};
+         }
+       };
+
+       item.num_leaves = 0u;
 
-      m_DirtyList = nullptr;
+       add_leaf(entity->get<MeshRenderer>());
+       add_leaf(entity->get<SkinnedMeshRenderer>());
+       add_leaf(entity->get<SpriteRenderer>());
+     },
+     k_BoundsUpdateGrainSize);
+
+    std::for_each_n(moved, num_moved, [this](const MovedTransform& item) {
+      std::for_each_n(item.leaves, item.num_leaves, [this](const MovedLeaf& leaf) {
+        m_BVHTree.markLeafDirty(leaf.node, leaf.bounds);
+      });
+    });
+  }
+
+  void Scene::dropDestroyedFromDirtyList()
+  {
+    // NOTE(SR):
+    //   Newly created Entities sit in the dirty list until the next update, doing one pass
+    //   here saves each destroyed transform from searching the list once it is collected.
+
+    bfTransform** link = &m_DirtyList;
+
+    while (*link)
+    {
+      bfTransform* const transform = *link;
+
+      if (Entity::fromTransform(transform)->isFlagSet(Entity::IS_PENDING_DELETED))
+      {
+        *link = std::exchange(transform->dirty_list_next, nullptr);
+        transform->flags &= ~(BF_TRANSFORM_IN_DIRTY_LIST | BF_TRANSFORM_FLUSH_PENDING);
+      }
+      else
+      {
+        link = &transform->dirty_list_next;
+      }
     }
   }
 
@@ -3,6 +3,9 @@
 #include "bf/bf_hash.hpp"
 #include "bf/core/bifrost_engine.hpp"
 
+#include <cstring>  // memcpy
+#include <utility>  // swap
+
 namespace bf
 {
   using OpaqueDepthBits     = BitRange<0, 16>;
@@ -15,10 +18,8 @@ namespace bf
   using AlphaBlendShaderBits    = BitRange<AlphaBlendVertexFmtBits::k_LastBit, 16>;
   using AlphaBlendDepthBits     = BitRange<AlphaBlendShaderBits::k_LastBit, 24>;
 
-  std::uint64_t material_to_bits(const DescSetBind& material_state)
+  static std::uint64_t hash_desc_set(const DescSetBind& material_state)
   {
-    return 0x0;
-
     std::uint64_t result;
 
     if (material_state.mode == DescSetBind::IMMEDIATE)
@@ -36,7 +37,7 @@ namespace bf
         result = hash::addU32(result, element.array_element_start);
         result = hash::addU32(result, element.num_handles);
 
-        for (std::uint32_t j = 0; j < info.num_bindings; ++j)
+        for (std::uint32_t j = 0; j < element.num_handles; ++j)
         {
           const bfGfxBaseHandle handle = element.handles[j];
           const std::uint64_t   offset = element.offsets[j];
@@ -56,6 +57,63 @@ namespace bf
     return result;
   }
 
+  // NOTE(SR):
+  //   Left out of the sort key so queues keep their current draw order,
+  //   only draws merged by `RenderQueue::MERGE_INSTANCES` are grouped by material (see `instance_group_bits`).
+  std::uint64_t material_to_bits(const DescSetBind& material_state)
+  {
+    return 0x0;
+
+    return hash_desc_set(material_state);
+  }
+
+  // Draws that can be instanced are grouped by mesh and material
+  // so that they end up next to each other after sorting.
+  static std::uint64_t instance_group_bits(const RC_DrawIndexed& command)
+  {
+    std::uint64_t result = hash_desc_set(command.material_binding);
+
+    result = hash::addPointer(result, command.instanced_program);
+    result = hash::addPointer(result, command.index_buffer);
+    result = hash::addU32(result, command.index_offset);
+    result = hash::addU32(result, command.num_indices);
+
+    for (std::uint32_t i = 0; i < command.num_vertex_buffers; ++i)
+    {
+      result = hash::addPointer(result, command.vertex_buffers[i]);
+    }
+
+    return result;
+  }
+
+  static bool can_be_instanced_together(const RC_DrawIndexed& lhs, const RC_DrawIndexed& rhs)
+  {
+    if (!rhs.instance_data || rhs.next ||
+        lhs.instanced_program != rhs.instanced_program ||
+        lhs.index_buffer != rhs.index_buffer ||
+        lhs.vertex_offset != rhs.vertex_offset ||
+        lhs.index_offset != rhs.index_offset ||
+        lhs.num_indices != rhs.num_indices ||
+        lhs.index_buffer_binding_offset != rhs.index_buffer_binding_offset ||
+        lhs.index_type != rhs.index_type ||
+        lhs.num_vertex_buffers != rhs.num_vertex_buffers ||
+        std::memcmp(&lhs.pipeline, &rhs.pipeline, sizeof(bfDrawCallPipeline)) != 0 ||
+        !lhs.material_binding.isSameAs(rhs.material_binding))
+    {
+      return false;
+    }
+
+    for (std::uint32_t i = 0; i < lhs.num_vertex_buffers; ++i)
+    {
+      if (lhs.vertex_buffers[i] != rhs.vertex_buffers[i] || lhs.vertex_binding_offsets[i] != rhs.vertex_binding_offsets[i])
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
   void DescSetBind::bind(bfGfxCommandListHandle command_list, std::uint32_t index)
   {
     switch (mode)
@@ -76,19 +134,226 @@ namespace bf
     }
   }
 
-  RenderQueue::RenderQueue(std::uint8_t features) :
-    key_stream_memory{},
-    command_stream_memory{},
-    num_keys{0},
+  bool DescSetBind::isSameAs(const DescSetBind& rhs) const
+  {
+    if (mode != rhs.mode)
+    {
+      return false;
+    }
+
+    if (mode == RETAINED)
+    {
+      return retained_mode_set == rhs.retained_mode_set;
+    }
+
+    const bfDescriptorSetInfo& lhs_info = immediate_mode_set;
+    const bfDescriptorSetInfo& rhs_info = rhs.immediate_mode_set;
+
+    if (lhs_info.num_bindings != rhs_info.num_bindings)
+    {
+      return false;
+    }
+
+    for (std::uint32_t i = 0; i < lhs_info.num_bindings; ++i)
+    {
+      const bfDescriptorElementInfo& lhs_element = lhs_info.bindings[i];
+      const bfDescriptorElementInfo& rhs_element = rhs_info.bindings[i];
+
+      if (lhs_element.type != rhs_element.type ||
+          lhs_element.binding != rhs_element.binding ||
+          lhs_element.array_element_start != rhs_element.array_element_start ||
+          lhs_element.num_handles != rhs_element.num_handles)
+      {
+        return false;
+      }
+
+      for (std::uint32_t j = 0; j < lhs_element.num_handles; ++j)
+      {
+        if (lhs_element.handles[j] != rhs_element.handles[j] ||
+            lhs_element.offsets[j] != rhs_element.offsets[j] ||
+            lhs_element.sizes[j] != rhs_element.sizes[j])
+        {
+          return false;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  RenderCommandPagePool::RenderCommandPagePool(IMemoryManager& memory) :
+    memory{memory},
+    free_list{nullptr}
+  {
+  }
+
+  RenderCommandPage* RenderCommandPagePool::acquire(std::size_t min_capacity)
+  {
+    std::lock_guard<std::mutex> lock{free_list_lock};
+
+    RenderCommandPage* page = free_list;
+
+    if (page && page->capacity >= min_capacity)
+    {
+      free_list = page->next;
+    }
+    else
+    {
+      const std::size_t capacity = min_capacity > k_PageSize ? min_capacity : k_PageSize;
+
+      page           = static_cast<RenderCommandPage*>(memory.allocate(sizeof(RenderCommandPage) + capacity));
+      page->capacity = capacity;
+    }
+
+    page->next = nullptr;
+    page->used = 0u;
+
+    return page;
+  }
+
+  void RenderCommandPagePool::release(RenderCommandPage* head, RenderCommandPage* tail)
+  {
+    if (head)
+    {
+      std::lock_guard<std::mutex> lock{free_list_lock};
+
+      tail->next = free_list;
+      free_list  = head;
+    }
+  }
+
+  RenderCommandPagePool::~RenderCommandPagePool()
+  {
+    while (free_list)
+    {
+      RenderCommandPage* const next = free_list->next;
+
+      memory.deallocate(free_list, sizeof(RenderCommandPage) + free_list->capacity);
+
+      free_list = next;
+    }
+  }
+
+  RenderCommandStream::RenderCommandStream(RenderCommandPagePool& pool) :
+    pool{pool},
+    head{nullptr},
+    tail{nullptr}
+  {
+  }
+
+  void* RenderCommandStream::allocate(std::size_t size, std::size_t alignment)
+  {
+    const auto align_offset = [alignment](RenderCommandPage* page) -> std::size_t {
+      const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(page->data() + page->used);
+
+      return page->used + ((alignment - (address & (alignment - 1))) & (alignment - 1));
+    };
+
+    std::size_t offset = tail ? align_offset(tail) : 0u;
+
+    if (!tail || offset + size > tail->capacity)
+    {
+      RenderCommandPage* const page = pool.acquire(size + alignment);
+
+      if (tail)
+      {
+        tail->next = page;
+      }
+      else
+      {
+        head = page;
+      }
+
+      tail   = page;
+      offset = align_offset(page);
+    }
+
+    tail->used = offset + size;
+
+    return tail->data() + offset;
+  }
+
+  void RenderCommandStream::clear()
+  {
+    pool.release(head, tail);
+    head = nullptr;
+    tail = nullptr;
+  }
+
+  RenderCommandStream::~RenderCommandStream()
+  {
+    clear();
+  }
+
+  RenderCommandRecorder::RenderCommandRecorder(RenderCommandPagePool& command_memory, std::uint8_t features) :
+    keys{command_memory.memory},
+    command_stream{command_memory},
     feature_flags{features}
   {
   }
 
+  void RenderCommandRecorder::clear()
+  {
+    command_stream.clear();
+    keys.clear();
+  }
+
+  RenderQueue::RenderQueue(RenderCommandPagePool& command_memory, std::uint8_t features) :
+    RenderCommandRecorder(command_memory, features),
+    sort_scratch{command_memory.memory},
+    sub_streams{command_memory.memory}
+  {
+  }
+
   void RenderQueue::clear()
   {
-    command_stream_memory.clear();
-    key_stream_memory.clear();
-    num_keys = 0;
+    RenderCommandRecorder::clear();
+
+    for (RenderCommandRecorder* const sub_stream : sub_streams)
+    {
+      sub_stream->clear();
+    }
+  }
+
+  void RenderQueue::prepareSubStreams(std::size_t num_streams)
+  {
+    IMemoryManager& memory = command_stream.pool.memory;
+
+    while (sub_streams.size() < num_streams)
+    {
+      sub_streams.push(memory.allocateT<RenderCommandRecorder>(command_stream.pool, feature_flags));
+    }
+  }
+
+  void RenderQueue::mergeSubStreams()
+  {
+    // NOTE(SR):
+    //   Only the keys are moved, the commands stay in the sub stream's
+    //   pages until the next `RenderQueue::clear`.
+
+    for (RenderCommandRecorder* const sub_stream : sub_streams)
+    {
+      const std::size_t num_sub_keys = sub_stream->keys.size();
+
+      if (num_sub_keys)
+      {
+        RenderSortKey* const dst_keys = keys.emplaceN(num_sub_keys, ArrayEmplaceUninitializedTag{});
+
+        std::memcpy(dst_keys, sub_stream->keys.data(), sizeof(RenderSortKey) * num_sub_keys);
+
+        sub_stream->keys.clear();
+      }
+    }
+  }
+
+  RenderQueue::~RenderQueue()
+  {
+    IMemoryManager& memory = command_stream.pool.memory;
+
+    for (RenderCommandRecorder* const sub_stream : sub_streams)
+    {
+      memory.deallocateT(sub_stream);
+    }
   }
 
   static const RenderSortKey* find_max_key(const RenderSortKey* keys, std::size_t num_keys)
@@ -108,28 +373,16 @@ namespace bf
     return best_key;
   }
 
-  static void counting_sort(LinearAllocator& alloc, RenderSortKey* keys, std::size_t num_keys, std::uint64_t place)
+  static void counting_sort(RenderSortKey* keys, RenderSortKey* result, std::size_t num_keys, std::uint64_t place)
   {
     static const std::size_t k_Max = 10;
 
-    LinearAllocatorScope mem_scope     = alloc;
-    RenderSortKey* const result        = alloc.allocateArrayTrivial<RenderSortKey>(num_keys);
-    std::uint64_t* const count_indices = alloc.allocateArrayTrivial<std::uint64_t>(num_keys);
-    std::uint64_t        count[k_Max]  = {};
-
-    // Initialize counts to 0,
-    // `result` and `count_indices` do not need initialization since all of there elements gets written to before reads.
-    std::memset(count, 0, k_Max * sizeof(std::uint64_t));
+    std::uint64_t count[k_Max] = {};
 
     for (std::size_t i = 0; i < num_keys; ++i)
     {
-      const std::uint64_t key_index = (keys[i].key / place) % k_Max;
-
-      // Cache this calculation for later
-      count_indices[i] = key_index;
-
       // Count each element
-      ++count[key_index];
+      ++count[(keys[i].key / place) % k_Max];
     }
 
     // Cumulative count
@@ -141,14 +394,14 @@ namespace bf
     // !!Evil Backwards Loop!! placing the elements in the correct order
     for (std::size_t i = num_keys; i-- > 0;)
     {
-      result[--count[count_indices[i]]] = keys[i];
+      result[--count[(keys[i].key / place) % k_Max]] = keys[i];
     }
 
     // Copy result back out to the input array.
     std::memcpy(keys, result, sizeof(RenderSortKey) * num_keys);
   }
 
-  static void radix_sort(LinearAllocator& alloc, RenderSortKey* keys, std::size_t num_keys)
+  static void radix_sort(RenderSortKey* keys, RenderSortKey* scratch, std::size_t num_keys)
   {
     if (num_keys > 1)
     {
@@ -156,7 +409,7 @@ namespace bf
 
       for (std::uint64_t place = 1; (max_key / place) > 0;)
       {
-        counting_sort(alloc, keys, num_keys, place);
+        counting_sort(keys, scratch, num_keys, place);
 
         const std::uint64_t old_place = place;
 
@@ -170,20 +423,175 @@ namespace bf
     }
   }
 
-  void RenderQueue::execute(bfGfxCommandListHandle command_list, const bfDescriptorSetInfo& camera_desc_set)
+  // Byte-wide LSD radix sort, each pass is a stable counting sort on one 8bit digit.
+  //
+  // All of the histograms are computed up front in a single read over the keys,
+  // this lets us skip any pass where every key shares the same digit which is
+  // common since not all fields of the key are always populated.
+  //
+  // References:
+  //   [http://stereopsis.com/radix.html]
+  //
+  static void radix_sort_bytes(RenderSortKey* keys, RenderSortKey* scratch, std::size_t num_keys)
+  {
+    static constexpr std::size_t k_RadixBits  = 8;
+    static constexpr std::size_t k_NumBuckets = std::size_t(1) << k_RadixBits;
+    static constexpr std::size_t k_NumDigits  = sizeof(RenderSortKey::key) * 8 / k_RadixBits;
+    static constexpr std::size_t k_DigitMask  = k_NumBuckets - 1;
+
+    if (num_keys <= 1)
+    {
+      return;
+    }
+
+    std::size_t histograms[k_NumDigits][k_NumBuckets] = {};
+
+    for (std::size_t i = 0; i < num_keys; ++i)
+    {
+      const std::uint64_t key = keys[i].key;
+
+      for (std::size_t digit = 0; digit < k_NumDigits; ++digit)
+      {
+        ++histograms[digit][(key >> (digit * k_RadixBits)) & k_DigitMask];
+      }
+    }
+
+    RenderSortKey* src = keys;
+    RenderSortKey* dst = scratch;
+
+    for (std::size_t digit = 0; digit < k_NumDigits; ++digit)
+    {
+      const std::size_t shift  = digit * k_RadixBits;
+      std::size_t*      counts = histograms[digit];
+
+      // Every key has the same value for this digit so this pass would be a plain copy.
+      if (counts[(src[0].key >> shift) & k_DigitMask] == num_keys)
+      {
+        continue;
+      }
+
+      // Exclusive prefix sum turns the counts into the write offset of each bucket.
+      std::size_t offset = 0;
+
+      for (std::size_t i = 0; i < k_NumBuckets; ++i)
+      {
+        const std::size_t count = counts[i];
+
+        counts[i] = offset;
+        offset += count;
+      }
+
+      for (std::size_t i = 0; i < num_keys; ++i)
+      {
+        dst[counts[(src[i].key >> shift) & k_DigitMask]++] = src[i];
+      }
+
+      std::swap(src, dst);
+    }
+
+    // An odd number of passes leaves the sorted result in the scratch buffer.
+    if (src != keys)
+    {
+      std::memcpy(keys, src, sizeof(RenderSortKey) * num_keys);
+    }
+  }
+
+  void RenderQueue::mergeInstances(RenderSortKey* keys_bgn, std::size_t num_keys, IRenderInstanceBuffer& instance_buffer)
+  {
+    const std::size_t   instance_data_size = instance_buffer.instanceDataSize();
+    const std::uint32_t max_instances      = instance_buffer.maxInstancesPerDraw();
+
+    for (std::size_t i = 0; i < num_keys;)
+    {
+      BaseRenderCommand* const cmd = keys_bgn[i].command;
+
+      if (cmd->type != RenderCommandType::DrawIndexed || !static_cast<RC_DrawIndexed*>(cmd)->instance_data || cmd->next)
+      {
+        ++i;
+        continue;
+      }
+
+      const RC_DrawIndexed& first_draw = *static_cast<RC_DrawIndexed*>(cmd);
+      std::uint32_t         num_merged = 1;
+
+      while (i + num_merged < num_keys && num_merged < max_instances)
+      {
+        const BaseRenderCommand* const next_cmd = keys_bgn[i + num_merged].command;
+
+        if (next_cmd->type != RenderCommandType::DrawIndexed ||
+            !can_be_instanced_together(first_draw, *static_cast<const RC_DrawIndexed*>(next_cmd)))
+        {
+          break;
+        }
+
+        ++num_merged;
+      }
+
+      const RenderInstanceRange      instances = instance_buffer.requestInstances(num_merged);
+      RC_DrawIndexedInstanced* const instanced = drawIndexedInstanced(first_draw.pipeline, first_draw.num_vertex_buffers, first_draw.index_buffer);
+
+      instanced->pipeline.program            = first_draw.instanced_program;
+      instanced->material_binding            = first_draw.material_binding;
+      instanced->object_binding              = instances.object_binding;
+      instanced->vertex_offset               = first_draw.vertex_offset;
+      instanced->index_offset                = first_draw.index_offset;
+      instanced->num_indices                 = first_draw.num_indices;
+      instanced->index_buffer_binding_offset = first_draw.index_buffer_binding_offset;
+      instanced->index_type                  = first_draw.index_type;
+      instanced->first_instance              = instances.first_instance;
+      instanced->num_instances               = num_merged;
+
+      std::memcpy(instanced->vertex_buffers, first_draw.vertex_buffers, sizeof(bfBufferHandle) * first_draw.num_vertex_buffers);
+      std::memcpy(instanced->vertex_binding_offsets, first_draw.vertex_binding_offsets, sizeof(bfBufferSize) * first_draw.num_vertex_buffers);
+
+      char* instance_data = static_cast<char*>(instances.data);
+
+      for (std::uint32_t j = 0; j < num_merged; ++j)
+      {
+        RenderSortKey& merged_key = keys_bgn[i + j];
+
+        std::memcpy(instance_data, static_cast<const RC_DrawIndexed*>(merged_key.command)->instance_data, instance_data_size);
+        instance_data += instance_data_size;
+
+        // The rest of the merged keys are left in place with no command to execute.
+        merged_key.command = nullptr;
+      }
+
+      keys_bgn[i].command = instanced;
+
+      i += num_merged;
+    }
+  }
+
+  void RenderQueue::execute(bfGfxCommandListHandle command_list, const bfDescriptorSetInfo& camera_desc_set, IRenderInstanceBuffer* instance_buffer)
   {
+    mergeSubStreams();
+
+    const std::size_t num_keys = keys.size();
+
     if (!num_keys)
     {
       return;
     }
 
     bfShaderProgramHandle last_program = nullptr;
-    RenderSortKey* const  keys_bgn     = firstKey();
+    RenderSortKey* const  keys_bgn     = keys.data();
 
     // The overlay is assumed to be correctly submitted back to front
     if (feature_flags & SORT_COMMANDS)
     {
-      radix_sort(key_stream_memory, keys_bgn, num_keys);
+      sort_scratch.clear();
+
+      RenderSortKey* const scratch = sort_scratch.emplaceN(num_keys, ArrayEmplaceUninitializedTag{});
+
+      if (feature_flags & SORT_RADIX_BYTES)
+      {
+        radix_sort_bytes(keys_bgn, scratch, num_keys);
+      }
+      else
+      {
+        radix_sort(keys_bgn, scratch, num_keys);
+      }
 
       /*
        assert(std::is_sorted(keys_bgn, keys_bgn + num_keys, [](const RenderSortKey& a, const RenderSortKey& b) {
@@ -192,6 +600,13 @@ namespace bf
       //*/
     }
 
+    if (feature_flags & MERGE_INSTANCES)
+    {
+      assert(instance_buffer && "An instance buffer is required for merging draws.");
+
+      mergeInstances(keys_bgn, num_keys, *instance_buffer);
+    }
+
     for (std::size_t i = 0; i < num_keys; ++i)
     {
       RenderSortKey* const sort_key    = keys_bgn + i;
@@ -229,6 +644,8 @@ namespace bf
           {
             RC_DrawIndexed* const draw_elements = static_cast<RC_DrawIndexed*>(current_cmd);
 
+            assert(!draw_elements->instance_data && "Draws with instance data must be submitted to a queue with `MERGE_INSTANCES`.");
+
             bfGfxCmdList_bindDrawCallPipeline(command_list, &draw_elements->pipeline);
 
             if (last_program != draw_elements->pipeline.program)
@@ -250,6 +667,37 @@ namespace bf
             bfGfxCmdList_drawIndexed(command_list, draw_elements->num_indices, draw_elements->index_offset, draw_elements->vertex_offset);
             break;
           }
+          case RenderCommandType::DrawIndexedInstanced:
+          {
+            RC_DrawIndexedInstanced* const draw_instanced = static_cast<RC_DrawIndexedInstanced*>(current_cmd);
+
+            bfGfxCmdList_bindDrawCallPipeline(command_list, &draw_instanced->pipeline);
+
+            if (last_program != draw_instanced->pipeline.program)
+            {
+              bfGfxCmdList_bindDescriptorSet(command_list, k_GfxCameraSetIndex, &camera_desc_set);
+              last_program = draw_instanced->pipeline.program;
+            }
+
+            draw_instanced->material_binding.bind(command_list, k_GfxMaterialSetIndex);
+            draw_instanced->object_binding.bind(command_list, k_GfxObjectSetIndex);
+
+            bfGfxCmdList_bindVertexBuffers(
+             command_list,
+             0,
+             draw_instanced->vertex_buffers,
+             draw_instanced->num_vertex_buffers,
+             draw_instanced->vertex_binding_offsets);
+            bfGfxCmdList_bindIndexBuffer(command_list, draw_instanced->index_buffer, draw_instanced->index_buffer_binding_offset, draw_instanced->index_type);
+            bfGfxCmdList_drawIndexedInstanced(
+             command_list,
+             draw_instanced->num_indices,
+             draw_instanced->index_offset,
+             draw_instanced->vertex_offset,
+             draw_instanced->first_instance,
+             draw_instanced->num_instances);
+            break;
+          }
           case RenderCommandType::Group:
           {
             const RC_Group* const group_cmd = static_cast<RC_Group*>(current_cmd);
@@ -271,13 +719,13 @@ namespace bf
     }
   }
 
-  std::uint64_t makeKey(bool do_front_to_back, const DescSetBind& material_state, const bfDrawCallPipeline& pipeline, float depth)
+  std::uint64_t makeKey(bool do_front_to_back, std::uint64_t material_hash, const bfDrawCallPipeline& pipeline, float depth)
   {
     using namespace Bits;
 
     if (do_front_to_back)
     {
-      const std::uint64_t material_bits   = material_to_bits(material_state) & max_value<std::uint64_t, OpaqueMaterialBits::k_NumBits>();
+      const std::uint64_t material_bits   = material_hash & max_value<std::uint64_t, OpaqueMaterialBits::k_NumBits>();
       const std::uint64_t vertex_fmt_bits = hash::reducePointer<std::uint16_t>(pipeline.vertex_layout);
       const std::uint64_t shader_bits     = hash::reducePointer<std::uint16_t>(pipeline.program);
       const std::uint64_t depth_bits      = depth_to_bits(-depth, OpaqueDepthBits::k_NumBits);
@@ -298,7 +746,7 @@ namespace bf
     }
     else
     {
-      const std::uint64_t material_bits   = material_to_bits(material_state) & max_value<std::uint64_t, AlphaBlendMaterialBits::k_NumBits>();
+      const std::uint64_t material_bits   = material_hash & max_value<std::uint64_t, AlphaBlendMaterialBits::k_NumBits>();
       const std::uint64_t vertex_fmt_bits = hash::reducePointer<std::uint16_t>(pipeline.vertex_layout);
       const std::uint64_t shader_bits     = hash::reducePointer<std::uint16_t>(pipeline.program);
       const std::uint64_t depth_bits      = depth_to_bits(depth, AlphaBlendDepthBits::k_NumBits);
@@ -319,14 +767,14 @@ namespace bf
     }
   }
 
-  RC_Group* RenderQueue::group()
+  RC_Group* RenderCommandRecorder::group()
   {
     RC_Group* const cmd = pushAlloc<RC_Group>();
 
     return cmd;
   }
 
-  RC_SetScissorRect* RenderQueue::setScissorRect(bfScissorRect rect)
+  RC_SetScissorRect* RenderCommandRecorder::setScissorRect(bfScissorRect rect)
   {
     RC_SetScissorRect* const cmd = pushAlloc<RC_SetScissorRect>();
 
@@ -335,7 +783,7 @@ namespace bf
     return cmd;
   }
 
-  RC_DrawArrays* RenderQueue::drawArrays(const bfDrawCallPipeline& pipeline, std::uint32_t num_vertex_buffers)
+  RC_DrawArrays* RenderCommandRecorder::drawArrays(const bfDrawCallPipeline& pipeline, std::uint32_t num_vertex_buffers)
   {
     RC_DrawArrays* const cmd = pushAlloc<RC_DrawArrays>();
 
@@ -353,7 +801,7 @@ namespace bf
     return cmd;
   }
 
-  RC_DrawIndexed* RenderQueue::drawIndexed(const bfDrawCallPipeline& pipeline, std::uint32_t num_vertex_buffers, bfBufferHandle index_buffer)
+  RC_DrawIndexed* RenderCommandRecorder::drawIndexed(const bfDrawCallPipeline& pipeline, std::uint32_t num_vertex_buffers, bfBufferHandle index_buffer)
   {
     RC_DrawIndexed* const cmd = pushAlloc<RC_DrawIndexed>();
 
@@ -372,33 +820,50 @@ namespace bf
     return cmd;
   }
 
-  std::uint64_t RenderQueue::makeKeyFor(RC_DrawIndexed* command, float distance_to_camera) const
+  RC_DrawIndexedInstanced* RenderCommandRecorder::drawIndexedInstanced(const bfDrawCallPipeline& pipeline, std::uint32_t num_vertex_buffers, bfBufferHandle index_buffer)
   {
-    return makeKey(feature_flags & SORT_DEPTH_FTB, command->material_binding, command->pipeline, distance_to_camera);
+    RC_DrawIndexedInstanced* const cmd = pushAlloc<RC_DrawIndexedInstanced>();
+
+    cmd->pipeline               = pipeline;
+    cmd->num_vertex_buffers     = num_vertex_buffers;
+    cmd->vertex_buffers         = pushAllocArray<bfBufferHandle>(num_vertex_buffers);
+    cmd->vertex_binding_offsets = pushAllocArray<bfBufferSize>(num_vertex_buffers);
+    cmd->index_buffer           = index_buffer;
+
+    for (std::size_t i = 0; i < num_vertex_buffers; ++i)
+    {
+      cmd->vertex_buffers[i]         = nullptr;
+      cmd->vertex_binding_offsets[i] = 0u;
+    }
+
+    return cmd;
   }
 
-  std::uint64_t RenderQueue::makeKeyFor(RC_DrawArrays* command, float distance_to_camera) const
+  std::uint64_t RenderCommandRecorder::makeKeyFor(RC_DrawIndexed* command, float distance_to_camera) const
   {
-    return makeKey(feature_flags & SORT_DEPTH_FTB, command->material_binding, command->pipeline, distance_to_camera);
+    const bool          is_mergeable  = (feature_flags & MERGE_INSTANCES) && command->instance_data;
+    const std::uint64_t material_hash = is_mergeable ? instance_group_bits(*command) : material_to_bits(command->material_binding);
+
+    return makeKey(feature_flags & SORT_DEPTH_FTB, material_hash, command->pipeline, distance_to_camera);
   }
 
-  void RenderQueue::submit(RC_DrawArrays* command, float distance_to_camera)
+  std::uint64_t RenderCommandRecorder::makeKeyFor(RC_DrawArrays* command, float distance_to_camera) const
   {
-    submit(makeKeyFor(command, distance_to_camera), command);
+    return makeKey(feature_flags & SORT_DEPTH_FTB, material_to_bits(command->material_binding), command->pipeline, distance_to_camera);
   }
 
-  void RenderQueue::submit(RC_DrawIndexed* command, float distance_to_camera)
+  void RenderCommandRecorder::submit(RC_DrawArrays* command, float distance_to_camera)
   {
     submit(makeKeyFor(command, distance_to_camera), command);
   }
 
-  void RenderQueue::submit(std::uint64_t key, BaseRenderCommand* command)
+  void RenderCommandRecorder::submit(RC_DrawIndexed* command, float distance_to_camera)
   {
-    RenderSortKey* const sort_key = key_stream_memory.allocateT<RenderSortKey>();
-
-    sort_key->key     = key;
-    sort_key->command = command;
+    submit(makeKeyFor(command, distance_to_camera), command);
+  }
 
-    ++num_keys;
+  void RenderCommandRecorder::submit(std::uint64_t key, BaseRenderCommand* command)
+  {
+    keys.push({key, command});
   }
 }  // namespace bf
@@ -15,7 +15,8 @@ using namespace std::chrono_literals;
 
 namespace bf
 {
-  static constexpr float k_SecToMs = 1000.0f;
+  static constexpr float             k_SecToMs        = 1000.0f;
+  static constexpr gc::CollectBudget k_EntityGCBudget = {1024u, 1ms};  //!< Large despawn waves are freed over a few frames rather than all at once.
 
   namespace detail
   {
@@ -77,6 +78,7 @@ namespace bf
     m_MainMemory{main_memory, main_memory_size},
 #endif
     m_TempMemory{static_cast<char*>(m_MainMemory.allocate(main_memory_size / 4)), main_memory_size / 4},
+    m_EntityStorage{m_MainMemory},
     m_Assets{*this, m_MainMemory},
     m_StateMachine{*this, m_MainMemory},
     m_Scripting{},
@@ -86,7 +88,8 @@ namespace bf
     m_DebugRenderer{m_MainMemory},
     m_Gfx2D{nullptr},
     m_2DScreenCommands{nullptr},
-    m_2DScreenRenderQueue{},
+    m_RenderCommandMemory{m_MainMemory},
+    m_2DScreenRenderQueue{m_RenderCommandMemory},
     m_2DScreenUBO{},
     m_CameraMemory{},
     m_CameraList{nullptr},
@@ -101,7 +104,8 @@ namespace bf
     m_TimeStepLag{0ns},
     m_CurrentTime{},
     m_State{EngineState::RUNTIME_PLAYING},
-    m_IsInMiddleOfFrame{false}
+    m_IsInMiddleOfFrame{false},
+    m_EntityGCStats{}
   {
 #if USE_CRT_HEAP
     (void)main_memory;
@@ -135,7 +139,7 @@ namespace bf
 
   RenderView* Engine::borrowCamera(const CameraRenderCreateParams& params)
   {
-    return m_CameraMemory.allocateT<RenderView>(m_CameraList, m_Renderer.device(), m_Renderer.m_FrameInfo, params);
+    return m_CameraMemory.allocateT<RenderView>(m_CameraList, m_Renderer.device(), m_Renderer.m_FrameInfo, m_RenderCommandMemory, params);
   }
 
   void Engine::resizeCamera(RenderView* camera, int width, int height)
@@ -215,7 +219,7 @@ namespace bf
 
   EntityRef Engine::createEntity(Scene& scene, const StringRange& name)
   {
-    Entity* const entity = m_MainMemory.allocateT<Entity>(scene, name);
+    Entity* const entity = m_EntityStorage.allocateT<Entity>(scene, name);
 
     if (entity)
     {
@@ -382,7 +386,7 @@ namespace bf
     m_SceneStack.clear();
 
     // Entity Garbage Must be collected before 'm_SceneStack' is cleared.
-    gc::collect(m_MainMemory);
+    gc::collect(m_EntityStorage);
 
     m_Assets.clearDirtyList();
     m_Assets.setRootPath(nullptr);
@@ -479,6 +483,12 @@ namespace bf
       }
     }
 
+    // Transforms changed by the systems (behaviors) are deferred, bring them up to date before drawing.
+    if (scene)
+    {
+      scene->flushTransforms();
+    }
+
     for (auto& system : m_Systems)
     {
       if (system->isEnabled())
@@ -585,7 +595,7 @@ namespace bf
     m_Input.frameEnd();
     m_Renderer.frameEnd();
 
-    gc::collect(m_MainMemory);
+    m_EntityGCStats = gc::collect(m_EntityStorage, k_EntityGCBudget);
   }
 
   void Engine::resizeCameras()
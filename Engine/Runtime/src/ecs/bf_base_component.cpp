@@ -36,37 +36,55 @@ namespace bf
   template<>
   void ComponentTraits::onEnable<MeshRenderer>(MeshRenderer& comp, Engine& engine)
   {
-    comp.m_BHVNode = comp.scene().bvh().insert(&comp.owner(), comp.owner().transform());
+    if (!comp.scene().isBulkLoading())
+    {
+      comp.m_BHVNode = comp.scene().bvh().insert(&comp.owner(), comp.owner().transform());
+    }
   }
 
   template<>
   void ComponentTraits::onDisable<MeshRenderer>(MeshRenderer& comp, Engine& engine)
   {
-    comp.scene().bvh().remove(comp.m_BHVNode);
+    if (!comp.scene().isBulkLoading())
+    {
+      comp.scene().bvh().remove(comp.m_BHVNode);
+    }
   }
 
   template<>
   void ComponentTraits::onEnable<SkinnedMeshRenderer>(SkinnedMeshRenderer& comp, Engine& engine)
   {
-    comp.m_BHVNode = comp.scene().bvh().insert(&comp.owner(), comp.owner().transform());
+    if (!comp.scene().isBulkLoading())
+    {
+      comp.m_BHVNode = comp.scene().bvh().insert(&comp.owner(), comp.owner().transform());
+    }
   }
 
   template<>
   void ComponentTraits::onDisable<SkinnedMeshRenderer>(SkinnedMeshRenderer& comp, Engine& engine)
   {
-    comp.scene().bvh().remove(comp.m_BHVNode);
+    if (!comp.scene().isBulkLoading())
+    {
+      comp.scene().bvh().remove(comp.m_BHVNode);
+    }
   }
 
   template<>
   void ComponentTraits::onEnable<SpriteRenderer>(SpriteRenderer& comp, Engine& engine)
   {
-    comp.m_BHVNode = comp.scene().bvh().insert(&comp.owner(), comp.owner().transform());
+    if (!comp.scene().isBulkLoading())
+    {
+      comp.m_BHVNode = comp.scene().bvh().insert(&comp.owner(), comp.owner().transform());
+    }
   }
 
   template<>
   void ComponentTraits::onDisable<SpriteRenderer>(SpriteRenderer& comp, Engine& engine)
   {
-    comp.scene().bvh().remove(comp.m_BHVNode);
+    if (!comp.scene().isBulkLoading())
+    {
+      comp.scene().bvh().remove(comp.m_BHVNode);
+    }
   }
 
   SpriteAnimator::SpriteAnimator(Entity& owner) :
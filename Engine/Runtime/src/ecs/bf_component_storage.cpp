@@ -0,0 +1,350 @@
+/******************************************************************************/
+/*!
+ * @file   bf_component_storage.cpp
+ * @author Shareef Abdoul-Raheem (http://blufedora.github.io/)
+ * @brief
+ *   Contains the type that should be used to store
+ *   engine components in a cache friendly manner.
+ *
+ * @version 0.0.1
+ * @date    2021-03-20
+ *
+ * @copyright Copyright (c) 2021
+ */
+/******************************************************************************/
+#include "bf/ecs/bf_component_storage.hpp"
+
+#include <algorithm> /* max, copy */
+#include <cassert>   /* assert    */
+#include <new>       /* new       */
+#include <utility>   /* move      */
+
+namespace bf
+{
+  static constexpr std::size_t k_ArchetypeChunkAlignment = 64u;  //!< Chunks start on a cache line.
+
+  //
+  // What the storage needs to know about each component type to
+  // manage the type erased columns of a chunk.
+  //
+  struct ComponentColumnInfo final
+  {
+    std::size_t size;
+    std::size_t alignment;
+    void (*relocate)(void* dst, void* src);  //!< Move constructs into `dst` and then destructs `src`.
+    void (*destruct)(void* object);
+  };
+
+  template<typename T>
+  static void componentRelocate(void* dst, void* src)
+  {
+    T* const src_object = static_cast<T*>(src);
+
+    new (dst) T(std::move(*src_object));
+    src_object->~T();
+  }
+
+  template<typename T>
+  static void componentDestruct(void* object)
+  {
+    static_cast<T*>(object)->~T();
+  }
+
+  template<typename... Ts>
+  struct ComponentColumnInfoTable
+  {
+    static constexpr ComponentColumnInfo value[] = {{sizeof(Ts), alignof(Ts), &componentRelocate<Ts>, &componentDestruct<Ts>}...};
+  };
+
+  static const ComponentColumnInfo& columnInfo(std::size_t type_index)
+  {
+    return ComponentPack::apply<ComponentColumnInfoTable>::value[type_index];
+  }
+
+  static std::size_t alignUp(std::size_t value, std::size_t alignment)
+  {
+    return (value + alignment - 1u) & ~(alignment - 1u);
+  }
+
+  template<typename F>
+  static void forEachTypeInMask(ComponentMask mask, F&& fn)
+  {
+    for (std::size_t type_index = 0u; mask; ++type_index, mask >>= 1u)
+    {
+      if (mask & 1u)
+      {
+        fn(type_index);
+      }
+    }
+  }
+
+  static void* rowComponent(ArchetypeChunk* chunk, std::size_t type_index, std::uint32_t row_index)
+  {
+    return static_cast<char*>(chunk->column(type_index)) + columnInfo(type_index).size * row_index;
+  }
+
+  // Archetype
+
+  Archetype::Archetype(IMemoryManager& memory, ComponentMask mask) :
+    m_Memory{memory},
+    m_Mask{mask},
+    m_ChunkCapacity{0u},
+    m_ChunkSize{0u},
+    m_ColumnOffsets{},
+    m_Chunks{memory},
+    m_NumRows{0u}
+  {
+    // NOTE(SR):
+    //   Chunk Layout: [ArchetypeChunk][ComponentRow* x capacity][ComponentMask x capacity][T0 x capacity][T1 x capacity]...
+    //
+    //   The capacity is first estimated assuming the worst case padding
+    //   between columns and then the real offsets are calculated from it.
+
+    std::size_t row_size      = sizeof(ComponentRow*) + sizeof(ComponentMask);
+    std::size_t max_padding   = 0u;
+    std::size_t max_alignment = alignof(ArchetypeChunk);
+
+    forEachTypeInMask(mask, [&](std::size_t type_index) {
+      const ComponentColumnInfo& info = columnInfo(type_index);
+
+      row_size += info.size;
+      max_padding += info.alignment - 1u;
+      max_alignment = std::max(max_alignment, info.alignment);
+    });
+
+    const std::size_t header_size = sizeof(ArchetypeChunk) + max_padding;
+
+    m_ChunkCapacity = std::uint32_t(std::max(header_size < k_ArchetypeChunkSize ? (k_ArchetypeChunkSize - header_size) / row_size : 0u, std::size_t(1u)));
+
+    std::size_t offset = sizeof(ArchetypeChunk) + (sizeof(ComponentRow*) + sizeof(ComponentMask)) * m_ChunkCapacity;
+
+    forEachTypeInMask(mask, [&](std::size_t type_index) {
+      const ComponentColumnInfo& info = columnInfo(type_index);
+
+      offset                      = alignUp(offset, info.alignment);
+      m_ColumnOffsets[type_index] = std::uint32_t(offset);
+      offset += info.size * m_ChunkCapacity;
+    });
+
+    assert(max_alignment <= k_ArchetypeChunkAlignment && "A component is over aligned for the chunk allocation.");
+
+    m_ChunkSize = alignUp(offset, max_alignment);
+  }
+
+  Archetype::~Archetype()
+  {
+    assert(m_NumRows == 0u && "All rows must be removed before destroying an Archetype.");
+
+    for (ArchetypeChunk* const chunk : m_Chunks)
+    {
+      m_Memory.deallocateAligned(chunk);
+    }
+  }
+
+  ComponentRow Archetype::allocateRow(ComponentRow* owner, ComponentMask enabled)
+  {
+    if (m_Chunks.isEmpty() || m_Chunks.back()->num_rows == m_ChunkCapacity)
+    {
+      ArchetypeChunk* const new_chunk = static_cast<ArchetypeChunk*>(m_Memory.allocateAligned(m_ChunkSize, k_ArchetypeChunkAlignment));
+
+      new_chunk->archetype        = this;
+      new_chunk->rows             = reinterpret_cast<ComponentRow**>(new_chunk + 1);
+      new_chunk->enabled          = reinterpret_cast<ComponentMask*>(new_chunk->rows + m_ChunkCapacity);
+      new_chunk->num_rows         = 0u;
+      new_chunk->num_partial_rows = 0u;
+
+      m_Chunks.push(new_chunk);
+    }
+
+    ArchetypeChunk* const chunk     = m_Chunks.back();
+    const std::uint32_t   row_index = chunk->num_rows++;
+
+    enabled &= m_Mask;
+
+    chunk->rows[row_index]    = owner;
+    chunk->enabled[row_index] = enabled;
+    chunk->num_partial_rows += enabled != m_Mask;
+    ++m_NumRows;
+
+    return {chunk, row_index};
+  }
+
+  void Archetype::freeRow(ArchetypeChunk* chunk, std::uint32_t index)
+  {
+    // NOTE(SR):
+    //   The components of the row at `index` have already been moved out or destroyed,
+    //   the hole is filled with the very last row so that only the last chunk is partially full.
+
+    ArchetypeChunk* const last_chunk = m_Chunks.back();
+    const std::uint32_t   last_index = last_chunk->num_rows - 1u;
+
+    chunk->num_partial_rows -= chunk->enabled[index] != m_Mask;
+
+    if (chunk != last_chunk || index != last_index)
+    {
+      forEachTypeInMask(m_Mask, [=](std::size_t type_index) {
+        columnInfo(type_index).relocate(
+         rowComponent(chunk, type_index, index),
+         rowComponent(last_chunk, type_index, last_index));
+      });
+
+      ComponentRow* const moved_row     = last_chunk->rows[last_index];
+      const ComponentMask moved_enabled = last_chunk->enabled[last_index];
+      const bool          moved_partial = moved_enabled != m_Mask;
+
+      chunk->rows[index]    = moved_row;
+      chunk->enabled[index] = moved_enabled;
+      *moved_row            = {chunk, index};
+
+      last_chunk->num_partial_rows -= moved_partial;
+      chunk->num_partial_rows += moved_partial;
+    }
+
+    --m_NumRows;
+
+    if (--last_chunk->num_rows == 0u)
+    {
+      m_Memory.deallocateAligned(last_chunk);
+      m_Chunks.pop();
+    }
+  }
+
+  // ComponentStorage
+
+  ComponentStorage::ComponentStorage(IMemoryManager& memory) :
+    m_Memory{memory},
+    m_Archetypes{memory}
+  {
+  }
+
+  std::size_t ComponentStorage::findChunks(ComponentMask mask, ArchetypeChunk** out_chunks) const
+  {
+    std::size_t num_chunks = 0u;
+
+    for (Archetype* const archetype : m_Archetypes)
+    {
+      if (archetype->has(mask))
+      {
+        if (out_chunks)
+        {
+          std::copy(archetype->chunks().begin(), archetype->chunks().end(), out_chunks + num_chunks);
+        }
+
+        num_chunks += archetype->chunks().size();
+      }
+    }
+
+    return num_chunks;
+  }
+
+  std::size_t ComponentStorage::count(ComponentMask mask) const
+  {
+    std::size_t result = 0u;
+
+    for (Archetype* const archetype : m_Archetypes)
+    {
+      if (archetype->has(mask))
+      {
+        for (const ArchetypeChunk* const chunk : archetype->chunks())
+        {
+          result += chunk->numEnabled(mask);
+        }
+      }
+    }
+
+    return result;
+  }
+
+  ComponentStorage::~ComponentStorage()
+  {
+    for (Archetype* const archetype : m_Archetypes)
+    {
+      // Any components left are destroyed without the owners being told.
+      while (!archetype->m_Chunks.isEmpty())
+      {
+        ArchetypeChunk* const chunk     = archetype->m_Chunks.back();
+        const std::uint32_t   row_index = chunk->num_rows - 1u;
+
+        forEachTypeInMask(archetype->m_Mask, [=](std::size_t type_index) {
+          columnInfo(type_index).destruct(rowComponent(chunk, type_index, row_index));
+        });
+
+        archetype->freeRow(chunk, row_index);
+      }
+
+      m_Memory.deallocateT(archetype);
+    }
+  }
+
+  void* ComponentStorage::addColumn(ComponentRow& row, std::size_t type_index)
+  {
+    const ComponentMask old_mask = row.chunk ? row.chunk->archetype->mask() : 0u;
+
+    assert(!(old_mask & (ComponentMask(1u) << type_index)) && "The row already has a component of this type.");
+
+    moveRow(row, old_mask | (ComponentMask(1u) << type_index));
+
+    return rowComponent(row.chunk, type_index, row.index);
+  }
+
+  void ComponentStorage::removeColumn(ComponentRow& row, std::size_t type_index)
+  {
+    assert(row.chunk && row.chunk->has(ComponentMask(1u) << type_index) && "The row does not have a component of this type.");
+
+    moveRow(row, row.chunk->archetype->mask() & ~(ComponentMask(1u) << type_index));
+  }
+
+  void ComponentStorage::moveRow(ComponentRow& row, ComponentMask new_mask)
+  {
+    ArchetypeChunk* const src_chunk = row.chunk;
+    const std::uint32_t   src_index = row.index;
+    const ComponentMask   old_mask  = src_chunk ? src_chunk->archetype->mask() : 0u;
+    const ComponentMask   enabled   = src_chunk ? src_chunk->enabled[src_index] : 0u;
+    ComponentRow          dst_row   = {};
+
+    // NOTE(SR):
+    //   Components in both archetypes are moved over, components only in the old one are destroyed
+    //   and components only in the new one are left uninitialized for the caller to construct.
+    //
+    //   Moved components keep their enabled state and new components start out enabled.
+
+    if (new_mask)
+    {
+      dst_row = findOrCreateArchetype(new_mask)->allocateRow(&row, (enabled & new_mask) | (new_mask & ~old_mask));
+    }
+
+    if (src_chunk)
+    {
+      forEachTypeInMask(old_mask, [&](std::size_t type_index) {
+        const ComponentColumnInfo& info      = columnInfo(type_index);
+        void* const                component = rowComponent(src_chunk, type_index, src_index);
+
+        if (new_mask & (ComponentMask(1u) << type_index))
+        {
+          info.relocate(rowComponent(dst_row.chunk, type_index, dst_row.index), component);
+        }
+        else
+        {
+          info.destruct(component);
+        }
+      });
+
+      src_chunk->archetype->freeRow(src_chunk, src_index);
+    }
+
+    row = dst_row;
+  }
+
+  Archetype* ComponentStorage::findOrCreateArchetype(ComponentMask mask)
+  {
+    for (Archetype* const archetype : m_Archetypes)
+    {
+      if (archetype->mask() == mask)
+      {
+        return archetype;
+      }
+    }
+
+    return m_Archetypes.emplace(m_Memory.allocateT<Archetype>(m_Memory, mask));
+  }
+}  // namespace bf
@@ -0,0 +1,138 @@
+/******************************************************************************/
+/*!
+ * @file   bf_entity_storage.cpp
+ * @author Shareef Abdoul-Raheem (http://blufedora.github.io/)
+ * @brief
+ *   Pooled memory for Entities so that spawning and destroying a lot
+ *   of them does not go through the general purpose heap one at a time.
+ *
+ * @version 0.0.1
+ * @date    2021-02-20
+ *
+ * @copyright Copyright (c) 2021
+ */
+/******************************************************************************/
+#include "bf/ecs/bf_entity_storage.hpp"
+
+#include "bf/ecs/bf_entity.hpp"  // Entity
+
+#include <cassert>  // assert
+#include <new>      // new
+#include <utility>  // exchange
+
+namespace bf
+{
+  union EntityStorage::EntitySlot
+  {
+    EntitySlot* next_free;
+    alignas(Entity) char memory[sizeof(Entity)];
+  };
+
+  struct EntityStorage::EntityChunk
+  {
+    EntityChunk* next;
+    EntitySlot   slots[k_NumEntitiesPerChunk];
+  };
+
+  EntityStorage::EntityStorage(IMemoryManager& memory) :
+    IMemoryManager(),
+    NonCopyMoveable<EntityStorage>(),
+    m_Memory{memory},
+    m_Chunks{nullptr},
+    m_FreeList{nullptr},
+    m_NumFreeSlots{0u}
+  {
+  }
+
+  void EntityStorage::reserve(std::size_t num_entities)
+  {
+    if (num_entities > m_NumFreeSlots)
+    {
+      growBy((num_entities - m_NumFreeSlots + k_NumEntitiesPerChunk - 1u) / k_NumEntitiesPerChunk);
+    }
+  }
+
+  std::size_t EntityStorage::allocateEntities(std::size_t num_entities, Scene& scene, const StringRange& name, Entity** results)
+  {
+    reserve(num_entities);
+
+    std::size_t num_allocated = 0u;
+
+    while (num_allocated < num_entities && m_FreeList)
+    {
+      EntitySlot* const slot = m_FreeList;
+
+      m_FreeList = slot->next_free;
+      --m_NumFreeSlots;
+
+      results[num_allocated++] = new (slot->memory) Entity(scene, name);
+    }
+
+    return num_allocated;
+  }
+
+  void* EntityStorage::allocate(std::size_t size)
+  {
+    assert(size <= sizeof(EntitySlot) && "The EntityStorage can only allocate Entities.");
+    (void)size;
+
+    if (!m_FreeList && !growBy(1u))
+    {
+      return nullptr;
+    }
+
+    EntitySlot* const slot = m_FreeList;
+
+    m_FreeList = slot->next_free;
+    --m_NumFreeSlots;
+
+    return slot->memory;
+  }
+
+  void EntityStorage::deallocate(void* ptr, std::size_t num_bytes)
+  {
+    assert(num_bytes <= sizeof(EntitySlot) && "The EntityStorage can only allocate Entities.");
+    (void)num_bytes;
+
+    EntitySlot* const slot = static_cast<EntitySlot*>(ptr);
+
+    slot->next_free = m_FreeList;
+    m_FreeList      = slot;
+    ++m_NumFreeSlots;
+  }
+
+  EntityStorage::~EntityStorage()
+  {
+    while (m_Chunks)
+    {
+      m_Memory.deallocateT(std::exchange(m_Chunks, m_Chunks->next));
+    }
+  }
+
+  bool EntityStorage::growBy(std::size_t num_chunks)
+  {
+    while (num_chunks--)
+    {
+      EntityChunk* const chunk = m_Memory.allocateT<EntityChunk>();
+
+      if (!chunk)
+      {
+        return false;
+      }
+
+      chunk->next = m_Chunks;
+      m_Chunks    = chunk;
+
+      // NOTE(SR): Linked back to front so the slots are handed out in address order.
+      for (std::size_t i = k_NumEntitiesPerChunk; i-- > 0u;)
+      {
+        chunk->slots[i].next_free = m_FreeList;
+        m_FreeList                = &chunk->slots[i];
+      }
+
+      m_NumFreeSlots += k_NumEntitiesPerChunk;
+    }
+
+    return true;
+  }
+}  // namespace bf
@@ -35,14 +35,16 @@ namespace bf
     m_Hierarchy{},
     m_GCList{},
     m_Behaviors{sceneMemoryManager()},
-    m_ComponentHandles{},
+    m_ComponentRow{},
     m_Transform{},
     m_RefCount{ATOMIC_VAR_INIT(0)},
     m_ComponentActiveStates{},
     m_Flags{IS_ACTIVE | IS_SERIALIZABLE},
+    m_GCGeneration{0u},
     m_UUID{bfUUID_makeEmpty().as_number}
   {
     bfTransform_ctor(&m_Transform, &scene.m_DirtyList);
+    bfTransform_setDeferredFlush(&m_Transform, true);
   }
 
   Engine& Entity::engine() const
@@ -97,7 +99,7 @@ namespace bf
 
   EntityRef Entity::addChild(const StringRange& name)
   {
-    EntityRef child = EntityRef{sceneMemoryManager().allocateT<Entity>(scene(), name)};
+    EntityRef child = EntityRef{engine().entityStorage().allocateT<Entity>(scene(), name)};
 
     child->attachToParent(this);
 
@@ -300,7 +302,7 @@ namespace bf
       if (serializer.pushObject("m_Components"))
       {
         ComponentStorage::forEachType([&serializer, this](auto t) {
-          using T = typename bfForEachTemplateT(t)::TObject;
+          using T = bfForEachTemplateT(t);
 
           const StringRange name = g_EngineComponentInfo[bfForEachTemplateIndex(t)].name;
 
@@ -432,11 +434,22 @@ namespace bf
   Entity::~Entity()
   {
     // Components
-    ComponentStorage::forEachType([this](auto t) {
-      using T = typename bfForEachTemplateT(t)::TObject;
-      remove<T>();
+    Engine& engine = this->engine();
+
+    ComponentStorage::forEachType([this, &engine](auto t) {
+      using T = bfForEachTemplateT(t);
+
+      T* const component = get<T>();
+
+      if (component)
+      {
+        ComponentTraits::onDisable(*component, engine);
+        ComponentTraits::onDestroy(*component, engine);
+      }
     });
 
+    sceneComponentStorage().removeAll(m_ComponentRow);
+
     // Behaviors
     for (BaseBehavior* const behavior : m_Behaviors)
     {
@@ -465,7 +478,7 @@ namespace bf
     if (was_active != is_active)
     {
       ComponentStorage::forEachType([this, was_active, is_active](auto t) {
-        using T = typename bfForEachTemplateT(t)::TObject;
+        using T = bfForEachTemplateT(t);
         // A component is active if both the Entity itself is active and it is active.
         setComponentActiveImpl<T>(was_active, is_active, isComponentActive<T>());
       });
@@ -593,9 +606,9 @@ namespace bf
     sceneMemoryManager().deallocateT(behavior);
   }
 
-  ComponentStorage& Entity::sceneComponentStorage(bool is_active) const
+  ComponentStorage& Entity::sceneComponentStorage() const
   {
-    return is_active ? m_OwningScene.m_ActiveComponents : m_OwningScene.m_InactiveComponents;
+    return m_OwningScene.m_Components;
   }
 
   IMemoryManager& Entity::sceneMemoryManager() const
@@ -16,6 +16,8 @@
 #include "bf/ecs/bf_entity.hpp"
 #include "bf/utility/bifrost_uuid.hpp"
 
+#include <chrono>  // steady_clock
+
 namespace bf
 {
   EntityRef::EntityRef(Entity* object) noexcept :
@@ -147,7 +149,8 @@ namespace bf
 
   namespace gc
   {
-    static constexpr int k_InitialMapSize = 256;
+    static constexpr int         k_InitialMapSize    = 256;
+    static constexpr std::size_t k_TimeCheckInterval = 32u;  //!< Number of Entities looked at between checks of the time budget.
 
     using UUIDToObject = HashTable<bfUUIDNumber, Entity*, k_InitialMapSize, UUIDHasher, UUIDEqual>;
 
@@ -163,12 +166,20 @@ namespace bf
 
       IMemoryManager*  memory;
       UUIDToObject     id_to_object;
-      ListView<Entity> gc_list;
+      std::size_t      num_registered;  //!< Number of non null entries in `id_to_object`.
+      ListView<Entity> free_list;       //!< Entities that had no references when removed, these can be freed without a search.
+      ListView<Entity> gc_list;         //!< Entities that were still referenced the last time they were looked at.
+      std::size_t      num_pending;     //!< Number of Entities in both lists.
+      std::uint32_t    generation;      //!< Incremented each collect so that an Entity is only looked at once per collect.
 
       explicit GCContext(IMemoryManager* mem) :
         memory{mem},
         id_to_object{},
-        gc_list{&Entity::m_GCList}
+        num_registered{0u},
+        free_list{&Entity::m_GCList},
+        gc_list{&Entity::m_GCList},
+        num_pending{0u},
+        generation{0u}
       {
       }
 
@@ -207,53 +218,169 @@ namespace bf
       return entity && !entity->isFlagSet(Entity::IS_PENDING_DELETED) ? entity : nullptr;
     }
 
+    void reserve(std::size_t num_entities)
+    {
+      g_GCCtx->id_to_object.reserve(g_GCCtx->num_registered + num_entities);
+    }
+
     void removeEntity(Entity& object)
     {
-      g_GCCtx->gc_list.pushBack(object);
+      if (object.refCount() == 0)
+      {
+        g_GCCtx->free_list.pushBack(object);
+      }
+      else
+      {
+        object.m_GCGeneration = g_GCCtx->generation;
+        g_GCCtx->gc_list.pushBack(object);
+      }
+
+      ++g_GCCtx->num_pending;
     }
 
     void reviveEntity(Entity& object)
     {
       assert(object.hasUUID() && "The Entity must have a UUID to be registered to the GC system.");
 
-      g_GCCtx->id_to_object[GCContext::id(object)] = &object;
+      Entity*& entry = g_GCCtx->id_to_object[GCContext::id(object)];
+
+      if (!entry)
+      {
+        ++g_GCCtx->num_registered;
+      }
+
+      entry = &object;
     }
 
-    void collect(IMemoryManager& entity_memory)
+    static void freeEntity(IMemoryManager& entity_memory, Entity& entity)
     {
-      // TODO(Shareef): Don't do this every frame, maybe every few frames.
+      if (entity.hasUUID())
+      {
+        Entity** const entry = g_GCCtx->id_to_object.at(GCContext::id(entity));
+
+        if (entry && *entry == &entity)
+        {
+          *entry = nullptr;
+          --g_GCCtx->num_registered;
+        }
+      }
+
+      --g_GCCtx->num_pending;
+
+      entity_memory.deallocateT(&entity);
+    }
+
+    CollectStats collect(IMemoryManager& entity_memory, const CollectBudget& budget)
+    {
+      using Clock = std::chrono::steady_clock;
+
+      // NOTE(SR):
+      //   Entities that had no references when they were removed are freed first since that needs no search.
+      //   The referenced ones are then checked from the front of `gc_list`, ones that are still referenced
+      //   are moved to the back and stamped with this collect's generation so they are not checked twice.
+
+      GCContext&              ctx         = *g_GCCtx;
+      const Clock::time_point start_time  = Clock::now();
+      const std::uint32_t     generation  = ++ctx.generation;
+      CollectStats            stats       = {};
+      std::size_t             num_visited = 0u;
 
-      auto& gc_list = g_GCCtx->gc_list;
+      const auto is_over_budget = [&]() {
+        if (budget.max_entities && stats.num_freed >= budget.max_entities)
+        {
+          return true;
+        }
 
-      ListView<Entity> free_list{&Entity::m_GCList};
+        if (budget.max_time.count() && ++num_visited % k_TimeCheckInterval == 0u)
+        {
+          return Clock::now() - start_time >= budget.max_time;
+        }
 
-      for (auto it = gc_list.begin(); it != gc_list.end(); /* NO-OP */)
+        return false;
+      };
+
+      while (!ctx.free_list.isEmpty() && !is_over_budget())
       {
-        Entity& entity = *it;
+        Entity& entity = ctx.free_list.front();
+        ctx.free_list.popFront();
 
+        // An EntityRef may have been made to the Entity after it was removed.
         if (entity.refCount() == 0)
         {
-          it = gc_list.erase(it);
-          free_list.pushBack(entity);
+          freeEntity(entity_memory, entity);
+          ++stats.num_freed;
         }
         else
         {
-          ++it;
+          entity.m_GCGeneration = generation;
+          ctx.gc_list.pushBack(entity);
         }
       }
 
-      while (!free_list.isEmpty())
+      while (!ctx.gc_list.isEmpty() && ctx.gc_list.front().m_GCGeneration != generation && !is_over_budget())
       {
-        Entity& entity = free_list.back();
-        free_list.popBack();
+        Entity& entity = ctx.gc_list.front();
+        ctx.gc_list.popFront();
 
-        if (entity.hasUUID())
+        if (entity.refCount() == 0)
         {
-          g_GCCtx->id_to_object[GCContext::id(entity)] = nullptr;
+          freeEntity(entity_memory, entity);
+          ++stats.num_freed;
         }
+        else
+        {
+          entity.m_GCGeneration = generation;
+          ctx.gc_list.pushBack(entity);
+        }
+      }
+
+      stats.num_pending = ctx.num_pending;
+      stats.bytes_freed = stats.num_freed * sizeof(Entity);
+      stats.time_spent  = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_time);
 
-        entity_memory.deallocateT(&entity);
+      return stats;
+    }
+
+    CollectStats collect(IMemoryManager& entity_memory, const Scene& scene)
+    {
+      using Clock = std::chrono::steady_clock;
+
+      // Scene assets may be released after `quit`, by then there is nothing left pending.
+      if (!g_GCCtx)
+      {
+        return {};
       }
+
+      GCContext&              ctx        = *g_GCCtx;
+      const Clock::time_point start_time = Clock::now();
+      CollectStats            stats      = {};
+
+      const auto collect_list = [&](ListView<Entity>& list) {
+        for (auto it = list.begin(); it != list.end();)
+        {
+          Entity& entity = *it;
+
+          if (&entity.scene() == &scene && entity.refCount() == 0)
+          {
+            it = list.erase(it);
+            freeEntity(entity_memory, entity);
+            ++stats.num_freed;
+          }
+          else
+          {
+            ++it;
+          }
+        }
+      };
+
+      collect_list(ctx.free_list);
+      collect_list(ctx.gc_list);
+
+      stats.num_pending = ctx.num_pending;
+      stats.bytes_freed = stats.num_freed * sizeof(Entity);
+      stats.time_spent  = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_time);
+
+      return stats;
     }
 
     void quit()
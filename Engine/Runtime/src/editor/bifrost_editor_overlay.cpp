@@ -21,9 +21,10 @@
 
 #include <ImGuizmo/ImGuizmo.h>
 
+#include <atomic>
 #include <utility>
 
-extern int g_NumDrawnObjects;
+extern std::atomic_int g_NumDrawnObjects;
 
 namespace bf::editor
 {
@@ -1147,7 +1148,7 @@ namespace bf::editor
 
       if (ImGui::Begin("Project View"))
       {
-        ImGui::Text("g_NumDrawnObjects(%i)", g_NumDrawnObjects);
+        ImGui::Text("g_NumDrawnObjects(%i)", g_NumDrawnObjects.load());
 
         if (imgui_ext::inspect("Project Name", m_OpenProject->name()))
         {
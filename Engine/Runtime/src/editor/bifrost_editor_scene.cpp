@@ -262,7 +262,10 @@ namespace bf::editor
 
         if (transform_parent)
         {
-          Mat4x4_mult(&transform_parent->inv_world_transform, &entity_mat, &entity_mat);
+          Mat4x4 inv_parent_mat;
+          bfTransform_inverseWorldMatrix(transform_parent, &inv_parent_mat);
+
+          Mat4x4_mult(&inv_parent_mat, &entity_mat, &entity_mat);
         }
 
         Vec3f translation = {};
@@ -398,10 +401,13 @@ namespace bf::editor
     auto* const   skinned_mesh = entity->get<SkinnedMeshRenderer>();
     auto* const   sprite       = entity->get<SpriteRenderer>();
     HitTestResult result       = {};
+    Mat4x4        inv_world_transform;
+
+    bfTransform_inverseWorldMatrix(&entity->transform(), &inv_world_transform);
 
     if (mesh && mesh->m_Model)
     {
-      const HitTestResult mesh_hit = hitTestModel(ray, *mesh->m_Model, entity->transform().inv_world_transform);
+      const HitTestResult mesh_hit = hitTestModel(ray, *mesh->m_Model, inv_world_transform);
 
       if (mesh_hit.did_hit && mesh_hit.t < result.t)
       {
@@ -411,7 +417,7 @@ namespace bf::editor
 
     if (skinned_mesh && skinned_mesh->m_Model)
     {
-      const HitTestResult skinned_mesh_hit = hitTestModel(ray, *skinned_mesh->m_Model, entity->transform().inv_world_transform);
+      const HitTestResult skinned_mesh_hit = hitTestModel(ray, *skinned_mesh->m_Model, inv_world_transform);
 
       if (skinned_mesh_hit.did_hit && skinned_mesh_hit.t < result.t)
       {
@@ -479,35 +485,17 @@ namespace bf::editor
 
                 StdList<HitTestResult> clicked_nodes{engine.tempMemory()};
 
-                scene->bvh().traverseConditionally([this, &ray, &clicked_nodes](const BVHNode& node) -> bool {
-                  Vec3f aabb_min;
-                  Vec3f aabb_max;
-
-                  memcpy(&aabb_min, &node.bounds.min, sizeof(float) * 3);
-                  memcpy(&aabb_max, &node.bounds.max, sizeof(float) * 3);
-
-                  const auto ray_cast_result = bfRay3D_intersectsAABB(&ray, aabb_min, aabb_max);
-
-                  if (bvh_node::isLeaf(node))
-                  {
-                    Entity* const entity = static_cast<Entity*>(node.user_data);
-
-                    if (ray_cast_result.did_hit && (ray_cast_result.min_time >= 0.0f || ray_cast_result.max_time >= 0.0f))
-                    {
-                      const auto accurate_hit_test = hitTestEntity(ray, entity);
+                const BVHRayHit bvh_hit = scene->bvh().raycast(ray, FLT_MAX, [&ray](const BVHNode& leaf, float) -> float {
+                  const auto accurate_hit_test = hitTestEntity(ray, static_cast<Entity*>(leaf.user_data));
 
-                      if (accurate_hit_test.did_hit)
-                      {
-                        clicked_nodes.emplace_back(accurate_hit_test);
-                      }
-                    }
-
-                    return false;
-                  }
-
-                  return ray_cast_result.did_hit;
+                  return accurate_hit_test.did_hit ? accurate_hit_test.t : FLT_MAX;
                 });
 
+                if (bvh_hit.did_hit)
+                {
+                  clicked_nodes.emplace_back(HitTestResult{true, bvh_hit.time, static_cast<Entity*>(bvh_hit.user_data)});
+                }
+
                 const Vector3f camera_right = m_Camera->cpu_camera._right;
                 const Vector3f camera_up    = m_Camera->cpu_camera.up;
                 const Vector3f camera_fwd   = m_Camera->cpu_camera.forward;
@@ -678,7 +666,7 @@ namespace bf::editor
 
         // Light Icon Rendering
 
-        /* const ??? */ auto& lights   = scene->components<Light>();
+        const auto            lights   = scene->components<Light>();
         const auto&           renderer = engine.rendererSys();
 
         Renderable2DPrimitive primitive_proto;
@@ -733,7 +733,7 @@ namespace bf::editor
     bool has_missing_component = false;
 
     ComponentStorage::forEachType([&has_missing_component, &engine, &entity, &serializer](auto t) {
-      using T = typename bfForEachTemplateT(t)::TObject;
+      using T = bfForEachTemplateT(t);
 
       const StringRange& component_name = g_EngineComponentInfo[t.index].name;
 
@@ -827,7 +827,7 @@ namespace bf::editor
       if (ImGui::BeginCombo("Add Component", "+ Component", ImGuiComboFlags_None))
       {
         ComponentStorage::forEachType([&entity, &engine](auto t) {
-          using T = typename bfForEachTemplateT(t)::TObject;
+          using T = bfForEachTemplateT(t);
 
           const StringRange& component_name = g_EngineComponentInfo[t.index].name;
 
@@ -13,14 +13,23 @@
 #include "bf/graphics/bifrost_component_renderer.hpp"
 
 #include "bf/anim2D/bf_animation_system.hpp"
+#include "bf/core/bf_parallel_for.hpp"  // parallelForChunks
 #include "bf/core/bifrost_engine.hpp"
 #include "bf/ecs/bf_entity.hpp"
 #include "bf/ecs/bifrost_renderer_component.hpp"  // MeshRenderer
 
-int g_NumDrawnObjects;
+#include <atomic>  // atomic_int
+
+std::atomic_int g_NumDrawnObjects;
 
 namespace bf
 {
+  // Minimum number of MeshRenderers recorded by a single job.
+  static constexpr std::size_t k_MeshRecordingGrainSize = 64;
+
+  // Minimum number of SpriteRenderers gathered by a single job.
+  static constexpr std::size_t k_SpriteGatherGrainSize = 256;
+
   void ComponentRenderer::onInit(Engine& engine)
   {
     const auto& gfx_device    = engine.renderer().device();
@@ -70,53 +79,9 @@ namespace bf
 
       // Mark Visibility
 
-      //
-      // NOTE(SR): This can be optimized with Plane masking:
-      //   [https://cesium.com/blog/2015/08/04/fast-hierarchical-culling/]
-      //
-
-      bvh.traverseConditionally([&cpu_camera = camera.cpu_camera, &bvh](BVHNode& node) {
-        if (bvh_node::isLeaf(node))
-        {
-          node.is_visible = true;
-          return false;
-        }
-
-        const AABB& bounds = node.bounds;
+      bvh.cullFrustum(camera.cpu_camera.frustum, camera.bvh_culling);
 
-        Vector3f aabb_min;
-        Vector3f aabb_max;
-
-        memcpy(&aabb_min, &bounds.min, sizeof(float) * 3);
-        memcpy(&aabb_max, &bounds.max, sizeof(float) * 3);
-
-        const auto hit_result = bfFrustum_isAABBInside(&cpu_camera.frustum, aabb_min, aabb_max);
-
-        switch (hit_result)
-        {
-          case BF_FRUSTUM_TEST_OUTSIDE:
-          {
-            bvh.traverse(bvh.nodeToIndex(node), [](BVHNode& node) {
-              node.is_visible = false;
-            });
-
-            return false;
-          }
-          case BF_FRUSTUM_TEST_INTERSECTING:
-          {
-            return true;
-          }
-          case BF_FRUSTUM_TEST_INSIDE:
-          {
-            bvh.traverse(bvh.nodeToIndex(node), [](BVHNode& node) {
-              node.is_visible = true;
-            });
-
-            return false;
-          }
-            bfInvalidDefaultCase();
-        }
-      });
+      const BVHCullingState& visibility = camera.bvh_culling;
 
       // 3D Models
 
@@ -132,19 +97,49 @@ namespace bf
       pipeline.program       = engine_renderer.m_GBufferShader;
       pipeline.vertex_layout = engine_renderer.m_StandardVertexLayout;
 
-      for (MeshRenderer& renderer : scene->components<MeshRenderer>())
-      {
-        if (renderer.material() && renderer.model() && bvh.nodes[renderer.m_BHVNode].is_visible)
-        {
-          ComponentRenderer::pushModel(
-           camera,
-           &renderer.owner(),
-           *renderer.model(),
-           pipeline,
-           engine_renderer,
-           opaque_render_queue);
-        }
-      }
+      // Jobs are handed whole archetype chunks so each one walks its renderers linearly,
+      // renderers of inactive entities are in the same chunks but are disabled.
+
+      const ComponentStorage& components      = scene->componentStorage();
+      const std::size_t       num_meshes      = components.count(k_ComponentMask<MeshRenderer>);
+      const std::size_t       num_mesh_blocks = components.findChunks(k_ComponentMask<MeshRenderer>, nullptr);
+      ArchetypeChunk** const  mesh_blocks     = tmp_memory.allocateArrayTrivial<ArchetypeChunk*>(num_mesh_blocks);
+      const std::size_t       num_mesh_chunks = std::min(parallelChunkCount(num_meshes, k_MeshRecordingGrainSize), num_mesh_blocks);
+
+      components.findChunks(k_ComponentMask<MeshRenderer>, mesh_blocks);
+      opaque_render_queue.prepareSubStreams(num_mesh_chunks);
+
+      parallelForChunks(
+       num_mesh_blocks,
+       num_mesh_chunks,
+       [&](std::size_t chunk_index, std::size_t idx_bgn, std::size_t idx_end) {
+         RenderCommandRecorder& recorder  = opaque_render_queue.subStream(chunk_index);
+         int                    num_drawn = 0;
+
+         for (std::size_t block_index = idx_bgn; block_index < idx_end; ++block_index)
+         {
+           const ArchetypeChunk& mesh_block     = *mesh_blocks[block_index];
+           MeshRenderer* const   mesh_renderers = mesh_block.components<MeshRenderer>();
+
+           for (std::uint32_t i = 0u; i < mesh_block.size(); ++i)
+           {
+             MeshRenderer& renderer = mesh_renderers[i];
+
+             if (mesh_block.isEnabled(i, k_ComponentMask<MeshRenderer>) && renderer.material() && renderer.model() && visibility.isVisible(renderer.m_BHVNode))
+             {
+               num_drawn += ComponentRenderer::pushModel(
+                camera,
+                &renderer.owner(),
+                *renderer.model(),
+                pipeline,
+                engine_renderer,
+                recorder);
+             }
+           }
+         }
+
+         g_NumDrawnObjects.fetch_add(num_drawn, std::memory_order_relaxed);
+       });
 
       auto& anim_sys = engine.animationSys();
 
@@ -153,7 +148,7 @@ namespace bf
 
       for (SkinnedMeshRenderer& renderer : scene->components<SkinnedMeshRenderer>())
       {
-        if (renderer.material() && renderer.model() && bvh.nodes[renderer.m_BHVNode].is_visible)
+        if (renderer.material() && renderer.model() && visibility.isVisible(renderer.m_BHVNode))
         {
           const ModelAsset& model = *renderer.model();
 
@@ -191,32 +186,53 @@ namespace bf
 
       // 2D Sprites
 
-      auto&                  sprite_renderer_list  = scene->components<SpriteRenderer>();
+      struct SpriteChunk final
+      {
+        std::size_t offset;
+        std::size_t num_sprites;
+      };
+
+      const auto             sprite_renderers      = scene->query<SpriteRenderer>();
+      const std::size_t      num_sprite_renderers  = sprite_renderers.size();
       const std::size_t      num_per_frame_sprites = m_PerFrameSprites->size();
-      Renderable2DPrimitive* sprite_list           = tmp_memory.allocateArray<Renderable2DPrimitive>(sprite_renderer_list.size() + num_per_frame_sprites);
+      const std::size_t      num_sprite_chunks     = parallelChunkCount(num_sprite_renderers, k_SpriteGatherGrainSize);
+      Renderable2DPrimitive* sprite_list           = tmp_memory.allocateArray<Renderable2DPrimitive>(num_sprite_renderers + num_per_frame_sprites);
+      SpriteChunk* const     sprite_chunks         = tmp_memory.allocateArrayTrivial<SpriteChunk>(num_sprite_chunks);
       std::size_t            sprite_list_size      = 0;
 
-      const auto add_sprite_to_list = [sprite_list, &sprite_list_size, &bvh](SpriteRenderer& renderer) {
-        if (renderer.size().x > 0.0f && renderer.size().y > 0.0f && renderer.material() && bvh.nodes[renderer.m_BHVNode].is_visible)
-        {
-          Renderable2DPrimitive& dst_sprite = sprite_list[sprite_list_size++];
-          const bfTransform&     transform  = renderer.owner().transform();
+      // NOTE(SR):
+      //   Each job packs its visible sprites at the start of its own slice of
+      //   `sprite_list`, the slices are then moved together in chunk order.
 
-          dst_sprite.transform = transform.world_transform;
-          dst_sprite.material  = &*renderer.material();
-          dst_sprite.origin    = transform.world_position;
-          dst_sprite.size      = renderer.size();
-          dst_sprite.color     = renderer.color();
-          dst_sprite.uv_rect   = renderer.uvRect();
+      parallelForChunks(
+       num_sprite_renderers,
+       num_sprite_chunks,
+       [&](std::size_t chunk_index, std::size_t idx_bgn, std::size_t idx_end) {
+         std::size_t num_visible = 0;
 
-          ++g_NumDrawnObjects;
-        }
-      };
+         sprite_renderers.forEachInRange(idx_bgn, idx_end, [&](SpriteRenderer& renderer) {
+           if (renderer.size().x > 0.0f && renderer.size().y > 0.0f && renderer.material() && visibility.isVisible(renderer.m_BHVNode))
+           {
+             Renderable2DPrimitive& dst_sprite = sprite_list[idx_bgn + num_visible++];
+             const bfTransform&     transform  = renderer.owner().transform();
+
+             dst_sprite.transform = transform.world_transform;
+             dst_sprite.material  = &*renderer.material();
+             dst_sprite.origin    = transform.world_position;
+             dst_sprite.size      = renderer.size();
+             dst_sprite.color     = renderer.color();
+             dst_sprite.uv_rect   = renderer.uvRect();
+           }
+         });
 
-      for (SpriteRenderer& renderer : sprite_renderer_list)
-      {
-        add_sprite_to_list(renderer);
-      }
+         sprite_chunks[chunk_index] = {idx_bgn, num_visible};
+         g_NumDrawnObjects.fetch_add(int(num_visible), std::memory_order_relaxed);
+       });
+
+      std::for_each_n(sprite_chunks, num_sprite_chunks, [sprite_list, &sprite_list_size](const SpriteChunk& chunk) {
+        std::memmove(sprite_list + sprite_list_size, sprite_list + chunk.offset, chunk.num_sprites * sizeof(Renderable2DPrimitive));
+        sprite_list_size += chunk.num_sprites;
+      });
 
       std::memcpy(sprite_list + sprite_list_size, m_PerFrameSprites->data(), num_per_frame_sprites * sizeof(Renderable2DPrimitive));
       sprite_list_size += num_per_frame_sprites;
@@ -433,21 +449,39 @@ namespace bf
     m_PerFrameSprites->push(sprite);
   }
 
-  void ComponentRenderer::pushModel(RenderView&               camera,
-                                    Entity*                   entity,
-                                    const ModelAsset&         model,
-                                    const bfDrawCallPipeline& pipeline,
-                                    StandardRenderer&         engine_renderer,
-                                    RenderQueue&              render_queue,
-                                    float                     distance_from_camera)
+  int ComponentRenderer::pushModel(RenderView&               camera,
+                                   Entity*                   entity,
+                                   const ModelAsset&         model,
+                                   const bfDrawCallPipeline& pipeline,
+                                   StandardRenderer&         engine_renderer,
+                                   RenderCommandRecorder&    render_queue,
+                                   float                     distance_from_camera)
   {
+    const bfShaderProgramHandle instanced_program = (render_queue.feature_flags & RenderQueue::MERGE_INSTANCES) ? engine_renderer.instancedProgramFor(pipeline.program) : nullptr;
+    const ObjectUniformData*    instance_data     = nullptr;
+    int                         num_drawn         = 0;
+
+    if (instanced_program)
+    {
+      instance_data = render_queue.command_stream.allocateT<ObjectUniformData>(StandardRenderer::makeObjectUniformData(camera.cpu_camera.view_proj_cache, *entity));
+    }
+
     for (const Mesh& mesh : model.m_Meshes)
     {
       RC_DrawIndexed* const render_command = render_queue.drawIndexed(pipeline, 2, model.m_IndexBuffer);
       MaterialAsset*        material       = model.m_Materials[mesh.material_idx];
 
       render_command->material_binding.set(engine_renderer.makeMaterialInfo(*material));
-      render_command->object_binding.set(engine_renderer.makeObjectTransformInfo(camera.cpu_camera.view_proj_cache, camera.gpu_camera, *entity));
+
+      if (instanced_program)
+      {
+        render_command->instanced_program = instanced_program;
+        render_command->instance_data     = instance_data;
+      }
+      else
+      {
+        render_command->object_binding.set(engine_renderer.makeObjectTransformInfo(camera.cpu_camera.view_proj_cache, camera.gpu_camera, *entity));
+      }
 
       render_command->vertex_buffers[0]         = model.m_VertexBuffer;
       render_command->vertex_buffers[1]         = model.m_VertexBoneData;
@@ -458,7 +492,9 @@ namespace bf
 
       render_queue.submit(render_command, distance_from_camera);
 
-      ++g_NumDrawnObjects;
+      ++num_drawn;
     }
+
+    return num_drawn;
   }
 }  // namespace bf
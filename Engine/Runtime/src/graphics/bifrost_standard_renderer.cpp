@@ -373,12 +373,15 @@ namespace bf
     m_GBufferShader{nullptr},
     m_GBufferSelectionShader{nullptr},
     m_GBufferSkinnedShader{nullptr},
+    m_GBufferInstancedShader{nullptr},
     m_SSAOBufferShader{nullptr},
     m_SSAOBlurShader{nullptr},
     m_AmbientLighting{nullptr},
     m_LightShaders{nullptr},
     m_RenderablePool{memory},
     m_RenderableMapping{},
+    m_RenderableMappingLock{},
+    m_InstanceBuffer{memory},
     m_AutoRelease{memory},
     m_WhiteTexture{nullptr},
     m_DefaultMaterialTexture{nullptr},
@@ -389,6 +392,52 @@ namespace bf
   {
   }
 
+  GfxInstanceBuffer::GfxInstanceBuffer(IMemoryManager& memory) :
+    m_Buffer{memory},
+    m_FrameInfo{}
+  {
+  }
+
+  void GfxInstanceBuffer::init(bfGfxDeviceHandle device)
+  {
+    m_Buffer.init(device);
+  }
+
+  void GfxInstanceBuffer::frameBegin(const bfGfxFrameInfo& frame_info)
+  {
+    m_Buffer.clear();
+    m_FrameInfo = frame_info;
+  }
+
+  void GfxInstanceBuffer::flush()
+  {
+    m_Buffer.flushLinks(m_FrameInfo);
+  }
+
+  void GfxInstanceBuffer::deinit()
+  {
+    m_Buffer.deinit();
+  }
+
+  RenderInstanceRange GfxInstanceBuffer::requestInstances(std::uint32_t num_instances)
+  {
+    const std::pair<ObjectUniformData*, int> instances = m_Buffer.requestVertices(m_FrameInfo, int(num_instances));
+    LinkedBuffer::Link* const                link      = m_Buffer.currentLink();
+    const bfBufferSize                       offset    = link->gpu_buffer.offset(m_FrameInfo);
+    const bfBufferSize                       size      = sizeof(LinkedBuffer::TArray);
+    bfDescriptorSetInfo                      desc_set  = bfDescriptorSetInfo_make();
+
+    bfDescriptorSetInfo_addUniform(&desc_set, 0, 0, &offset, &size, &link->gpu_buffer.handle(), 1);
+
+    RenderInstanceRange result;
+
+    result.data           = instances.first;
+    result.first_instance = std::uint32_t(instances.second);
+    result.object_binding.set(desc_set);
+
+    return result;
+  }
+
   void StandardRenderer::init(const bfGfxContextCreateParams& gfx_create_params, bfWindow* main_window)
   {
     bfGfxInit(&gfx_create_params);
@@ -420,6 +469,8 @@ namespace bf
 
     initShaders();
 
+    m_InstanceBuffer.init(m_GfxDevice);
+
     {
       const auto limits = bfGfxDevice_limits(m_GfxDevice);
 
@@ -457,6 +508,8 @@ namespace bf
         point_light_buffer->u_NumLights = 0;
         spot_light_buffer->u_NumLights  = 0;
 
+        m_InstanceBuffer.frameBegin(m_FrameInfo);
+
         return bfGfxCmdList_begin(m_MainCmdList);
       }
     }
@@ -863,8 +916,10 @@ namespace bf
     bfGfxCmdList_endRenderpass(m_MainCmdList);
   }
 
-  void StandardRenderer::drawEnd() const
+  void StandardRenderer::drawEnd()
   {
+    m_InstanceBuffer.flush();
+
     bfGfxCmdList_end(m_MainCmdList);
     bfGfxCmdList_submit(m_MainCmdList);
   }
@@ -884,6 +939,8 @@ namespace bf
     }
     m_RenderablePool.clear();
 
+    m_InstanceBuffer.deinit();
+
     for (auto resource : m_AutoRelease)
     {
       bfGfxDevice_release_(m_GfxDevice, resource);
@@ -928,23 +985,46 @@ namespace bf
     return desc_set_material;
   }
 
+  ObjectUniformData StandardRenderer::makeObjectUniformData(const Mat4x4& view_proj_cache, Entity& entity)
+  {
+    ObjectUniformData result;
+
+    Mat4x4& model = entity.transform().world_transform;
+
+    Mat4x4_mult(&view_proj_cache, &model, &result.u_ModelViewProjection);
+
+    result.u_Model = model;
+    bfTransform_normalMatrix(&entity.transform(), &result.u_NormalModel);
+
+    return result;
+  }
+
+  bfShaderProgramHandle StandardRenderer::instancedProgramFor(bfShaderProgramHandle program) const
+  {
+    return program == m_GBufferShader ? m_GBufferInstancedShader : nullptr;
+  }
+
   bfDescriptorSetInfo StandardRenderer::makeObjectTransformInfo(const Mat4x4& view_proj_cache, const CameraGPUData& camera, Entity& entity)
   {
     const auto key = CameraObjectPair{&camera, &entity};
 
-    auto it = m_RenderableMapping.find(key);
-
     Renderable<ObjectUniformData>* renderable;
 
-    if (it == m_RenderableMapping.end())
     {
-      renderable = &m_RenderablePool.emplaceFront();
-      renderable->create(m_GfxDevice, m_FrameInfo);
-      m_RenderableMapping.emplace(key, renderable);
-    }
-    else
-    {
-      renderable = it->value();
+      std::lock_guard<std::mutex> lock{m_RenderableMappingLock};
+
+      auto it = m_RenderableMapping.find(key);
+
+      if (it == m_RenderableMapping.end())
+      {
+        renderable = &m_RenderablePool.emplaceFront();
+        renderable->create(m_GfxDevice, m_FrameInfo);
+        m_RenderableMapping.emplace(key, renderable);
+      }
+      else
+      {
+        renderable = it->value();
+      }
     }
 
     const bfBufferSize offset = renderable->transform_uniform.offset(m_FrameInfo);
@@ -954,14 +1034,7 @@ namespace bf
     {
       ObjectUniformData* const obj_data = static_cast<ObjectUniformData*>(bfBuffer_map(renderable->transform_uniform.handle(), offset, size));
 
-      Mat4x4& model = entity.transform().world_transform;
-
-      Mat4x4 model_view_proj;
-      Mat4x4_mult(&view_proj_cache, &model, &model_view_proj);
-
-      obj_data->u_ModelViewProjection = model_view_proj;
-      obj_data->u_Model               = model;
-      obj_data->u_NormalModel         = entity.transform().normal_transform;
+      *obj_data = makeObjectUniformData(view_proj_cache, entity);
 
       renderable->transform_uniform.flushCurrent(m_FrameInfo, size);
       bfBuffer_unMap(renderable->transform_uniform.handle());
@@ -984,7 +1057,7 @@ namespace bf
 
     // GBuffer
     beginGBufferPass(camera_gpu_data);
-    view.opaque_render_queue.execute(m_MainCmdList, desc_set_normal);
+    view.opaque_render_queue.execute(m_MainCmdList, desc_set_normal, &m_InstanceBuffer);
     view.transparent_render_queue.execute(m_MainCmdList, desc_set_normal);  // TODO(SR): This is not correct
     endPass();
 
@@ -1052,6 +1125,7 @@ namespace bf
   {
     const auto gbuffer_skinned_vert_module   = m_GLSLCompiler.createModule(m_GfxDevice, "assets/shaders/standard/gbuffer_skinned.vert.glsl");
     const auto gbuffer_vert_module           = m_GLSLCompiler.createModule(m_GfxDevice, "assets/shaders/standard/gbuffer.vert.glsl");
+    const auto gbuffer_instanced_vert_module = m_GLSLCompiler.createModule(m_GfxDevice, "assets/shaders/standard/gbuffer_instanced.vert.glsl");
     const auto gbuffer_frag_module           = m_GLSLCompiler.createModule(m_GfxDevice, "assets/shaders/standard/gbuffer.frag.glsl");
     const auto gbuffer_selection_frag_module = m_GLSLCompiler.createModule(m_GfxDevice, "assets/shaders/standard/gbuffer_selection.frag.glsl");
     const auto fullscreen_vert_module        = m_GLSLCompiler.createModule(m_GfxDevice, "assets/shaders/standard/fullscreen_quad.vert.glsl");
@@ -1065,6 +1139,7 @@ namespace bf
     m_GBufferShader                     = gfx::createShaderProgram(m_GfxDevice, 4, gbuffer_vert_module, gbuffer_frag_module, "GBuffer Shader");
     m_GBufferSelectionShader            = gfx::createShaderProgram(m_GfxDevice, 4, gbuffer_vert_module, gbuffer_selection_frag_module, "Selection GBuffer Shader");
     m_GBufferSkinnedShader              = gfx::createShaderProgram(m_GfxDevice, 4, gbuffer_skinned_vert_module, gbuffer_frag_module, "Skinned GBuffer");
+    m_GBufferInstancedShader            = gfx::createShaderProgram(m_GfxDevice, 4, gbuffer_instanced_vert_module, gbuffer_frag_module, "Instanced GBuffer");
     m_SSAOBufferShader                  = gfx::createShaderProgram(m_GfxDevice, 3, fullscreen_vert_module, ssao_frag_module, "SSAO Buffer");
     m_SSAOBlurShader                    = gfx::createShaderProgram(m_GfxDevice, 3, fullscreen_vert_module, ssao_blur_frag_module, "SSAO Blur Buffer");
     m_AmbientLighting                   = gfx::createShaderProgram(m_GfxDevice, 3, fullscreen_vert_module, ambient_light_frag_module, "A Light");
@@ -1084,6 +1159,10 @@ namespace bf
     bindings::addMaterial(m_GBufferSkinnedShader, BF_SHADER_STAGE_FRAGMENT);
     bindings::addCamera(m_GBufferSkinnedShader, BF_SHADER_STAGE_VERTEX);
 
+    bindings::addObject(m_GBufferInstancedShader, BF_SHADER_STAGE_VERTEX);
+    bindings::addMaterial(m_GBufferInstancedShader, BF_SHADER_STAGE_FRAGMENT);
+    bindings::addCamera(m_GBufferInstancedShader, BF_SHADER_STAGE_VERTEX);
+
     bindings::addCamera(m_SSAOBufferShader, BF_SHADER_STAGE_VERTEX | BF_SHADER_STAGE_FRAGMENT);
     bindings::addSSAOInputs(m_SSAOBufferShader, BF_SHADER_STAGE_FRAGMENT);
 
@@ -1104,6 +1183,7 @@ namespace bf
     bfShaderProgram_compile(m_GBufferShader);
     bfShaderProgram_compile(m_GBufferSelectionShader);
     bfShaderProgram_compile(m_GBufferSkinnedShader);
+    bfShaderProgram_compile(m_GBufferInstancedShader);
     bfShaderProgram_compile(m_SSAOBufferShader);
     bfShaderProgram_compile(m_SSAOBlurShader);
     bfShaderProgram_compile(m_AmbientLighting);
@@ -1113,6 +1193,7 @@ namespace bf
 
     m_AutoRelease.push(bfHandleBase(gbuffer_skinned_vert_module));
     m_AutoRelease.push(bfHandleBase(gbuffer_vert_module));
+    m_AutoRelease.push(bfHandleBase(gbuffer_instanced_vert_module));
     m_AutoRelease.push(bfHandleBase(gbuffer_frag_module));
     m_AutoRelease.push(bfHandleBase(gbuffer_selection_frag_module));
     m_AutoRelease.push(bfHandleBase(fullscreen_vert_module));
@@ -1125,6 +1206,7 @@ namespace bf
     m_AutoRelease.push(bfHandleBase(m_GBufferShader));
     m_AutoRelease.push(bfHandleBase(m_GBufferSelectionShader));
     m_AutoRelease.push(bfHandleBase(m_GBufferSkinnedShader));
+    m_AutoRelease.push(bfHandleBase(m_GBufferInstancedShader));
     m_AutoRelease.push(bfHandleBase(m_SSAOBufferShader));
     m_AutoRelease.push(bfHandleBase(m_SSAOBlurShader));
     m_AutoRelease.push(bfHandleBase(m_AmbientLighting));
@@ -0,0 +1,59 @@
+#include "bf/core/bifrost_engine.hpp"
+
+#include <cstdio>  // printf
+#include <memory>  // unique_ptr
+#include <vector>  // vector
+
+using namespace bf;
+
+static constexpr std::size_t k_MainMemorySize = 64u * 1024u * 1024u;
+static constexpr std::size_t k_GCBudget       = 1024u;            // Same entity budget as `Engine::endFrame`.
+static constexpr std::size_t k_NumEntities    = k_GCBudget * 4u;  // More than a single budgeted collect can free.
+
+static int check(bool condition, const char* message)
+{
+  std::printf("[%s] %s\n", condition ? "PASS" : "FAIL", message);
+
+  return condition ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+  const auto main_memory = std::make_unique<char[]>(k_MainMemorySize);
+  const auto engine      = std::make_unique<Engine>(main_memory.get(), k_MainMemorySize, argc, argv);
+  int        num_failed  = 0;
+
+  gc::init(engine->mainMemory());
+
+  {
+    Scene                scene{*engine};
+    Scene                other_scene{*engine};
+    std::vector<Entity*> entities(k_NumEntities);
+    Entity*              other_entity;
+
+    scene.addEntities(k_NumEntities, entities.data(), "Entity");
+    other_scene.addEntities(1u, &other_entity, "Other Entity");
+
+    scene.destroyEntities(entities.data(), k_NumEntities);
+    other_scene.destroyEntities(&other_entity, 1u);
+
+    const gc::CollectStats frame_stats = gc::collect(engine->entityStorage(), gc::CollectBudget{k_GCBudget});
+
+    num_failed += check(frame_stats.num_freed == k_GCBudget, "A budgeted collect frees at most the budget.");
+    num_failed += check(frame_stats.num_pending > k_GCBudget, "Entities are still pending after a budgeted collect.");
+
+    // What `SceneDocument::onUnload` and `Scene::~Scene` do.
+    scene.removeAllEntities();
+
+    const gc::CollectStats unload_stats = gc::collect(engine->entityStorage(), scene);
+
+    num_failed += check(unload_stats.num_freed == 0u, "Unloading a scene frees all of its pending entities.");
+    num_failed += check(unload_stats.num_pending == 1u, "Pending entities from other scenes are left to the budgeted collect.");
+  }
+
+  num_failed += check(gc::collect(engine->entityStorage()).num_pending == 0u, "Destroying a scene leaves nothing pending.");
+
+  gc::quit();
+
+  return num_failed;
+}
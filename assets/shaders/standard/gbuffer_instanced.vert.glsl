@@ -0,0 +1,31 @@
+//
+// Author: Shareef Abdoul-Raheem
+// Standard Shader GBuffer
+//
+// The Position and Normal Data Are In World Space.
+// + Per instance object transforms.
+//
+#version 450
+
+#include "assets/shaders/standard/std_vertex_input.def.glsl"
+
+#include "assets/shaders/standard/camera.ubo.glsl"
+#include "assets/shaders/standard/object_instanced.ubo.glsl"
+
+layout(location = 0) out vec3 frag_WorldNormal;
+layout(location = 1) out vec3 frag_Color;
+layout(location = 2) out vec2 frag_UV;
+
+void main()
+{
+  ObjectInstanceData object = u_Instances[gl_InstanceIndex];
+
+  vec4 object_position = vec4(in_Position.xyz, 1.0);
+  vec4 clip_position   = object.u_ModelViewProjection * object_position;
+
+  frag_WorldNormal = mat3(object.u_NormalModel) * in_Normal.xyz;
+  frag_Color       = in_Color.rgb;
+  frag_UV          = in_UV;
+
+  gl_Position = clip_position;
+}
@@ -0,0 +1,19 @@
+#define k_MaxInstancesPerDraw 64
+
+//
+// Instanced Object Transform UBO Layout
+//
+// Same data as "object.ubo.glsl" but one element per instance,
+// indexed with 'gl_InstanceIndex' (includes the draw's first instance).
+//
+struct ObjectInstanceData
+{
+  mat4 u_ModelViewProjection;
+  mat4 u_Model;
+  mat4 u_NormalModel;
+};
+
+layout(std140, set = 3, binding = 0) uniform u_Set3Binding0
+{
+  ObjectInstanceData u_Instances[k_MaxInstancesPerDraw];
+};